@@ -0,0 +1,164 @@
+/******************************************************************************
+  DeviceReactor host shim - Arduino.h
+
+  Just enough of the Arduino core to build DeviceReactor sketches on a PC.
+  Time and inputs are driven by the replay runner (dr_replay.cpp); outputs
+  can be logged for comparison between library versions.
+
+  The pin layout is a Mega's (A0 = 54) unless DR_HOST_BOARD_UNO is defined,
+  which gives an Uno or Nano's (A0 = 14). Build with the layout of the board
+  the capture was made on; the runner checks it.
+
+  Not emulated: SPI, interrupts, AVR port registers.
+******************************************************************************/
+
+#ifndef DR_HOST_ARDUINO_H
+#define DR_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define LED_BUILTIN 13
+
+#ifdef DR_HOST_BOARD_UNO
+  #define NUM_DIGITAL_PINS 20
+  #define NUM_ANALOG_INPUTS 8  // A6/A7 of a Nano are pins 20 and 21
+  #define A0 14
+#else
+  #define NUM_DIGITAL_PINS 70
+  #define NUM_ANALOG_INPUTS 16
+  #define A0 54
+#endif
+#define A1 (A0 + 1)
+#define A2 (A0 + 2)
+#define A3 (A0 + 3)
+#define A4 (A0 + 4)
+#define A5 (A0 + 5)
+#define A6 (A0 + 6)
+#define A7 (A0 + 7)
+
+#define PROGMEM
+#define pgm_read_byte(p)  (*(const uint8_t*)(p))
+#define pgm_read_word(p)  (*(const uint16_t*)(p))
+#define pgm_read_dword(p) (*(const uint32_t*)(p))
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper*>(s))
+
+#define noInterrupts()
+#define interrupts()
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+int analogRead(uint8_t pin);
+void analogWrite(uint8_t pin, int value);
+void shiftOut(uint8_t dataPin, uint8_t clockPin, uint8_t bitOrder, uint8_t value);
+
+long random(long max);
+long random(long min, long max);
+void randomSeed(unsigned long seed);
+
+inline long map(long x, long inMin, long inMax, long outMin, long outMax) {
+  return (x - inMin) * (outMax - outMin) / (inMax - inMin) + outMin;
+}
+
+#define constrain(x, low, high) ((x) < (low) ? (low) : ((x) > (high) ? (high) : (x)))
+
+#define DEC 10
+#define HEX 16
+#define BIN 2
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+
+    size_t write(const uint8_t* buffer, size_t size) {
+      size_t n = 0;
+      while (size--) {
+        n += write(*buffer++);
+      }
+      return n;
+    }
+
+    virtual int availableForWrite() { return 0; }
+
+    size_t print(const char* s) { return write((const uint8_t*)s, strlen(s)); }
+    size_t print(const __FlashStringHelper* s) { return print(reinterpret_cast<const char*>(s)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(int v, int base = DEC) { return print((long)v, base); }
+    size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(long v, int base = DEC) {
+      if (base == DEC && v < 0) {
+        return print('-') + print((unsigned long)-v, base);
+      }
+      return print((unsigned long)v, base);
+    }
+    size_t print(unsigned long v, int base = DEC) {
+      char buf[8 * sizeof(long) + 1];
+      char* p = &buf[sizeof(buf) - 1];
+      *p = '\0';
+      do {
+        byte digit = v % base;
+        *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+        v /= base;
+      } while (v);
+      return print(p);
+    }
+    size_t print(double v, int digits = 2) {
+      char buf[32];
+      snprintf(buf, sizeof(buf), "%.*f", digits, v);
+      return print(buf);
+    }
+
+    size_t println() { return print("\r\n"); }
+    template <typename T> size_t println(T v) { size_t n = print(v); return n + println(); }
+    template <typename T> size_t println(T v, int base) { size_t n = print(v, base); return n + println(); }
+};
+
+class Stream : public Print {
+  public:
+    virtual int available() { return 0; }
+    virtual int read() { return -1; }
+    virtual int peek() { return -1; }
+};
+
+// Serial writes to stdout
+class HardwareSerial : public Stream {
+  public:
+    void begin(unsigned long) {}
+    size_t write(uint8_t c) { return fputc(c, stdout) == EOF ? 0 : 1; }
+    int availableForWrite() { return 64; }
+    using Print::write;
+    operator bool() { return true; }
+};
+
+extern HardwareSerial Serial;
+
+void setup();
+void loop();
+
+#endif // DR_HOST_ARDUINO_H
@@ -0,0 +1,241 @@
+/******************************************************************************
+  DeviceReactor host shim - replay runner
+
+  Runs a sketch on the PC against an input capture made with
+  device.recordInputs(). The virtual clock advances in fixed steps between
+  calls to loop(), and every recorded pin value is applied at the
+  millisecond it was sampled on the board.
+
+  Build (the sketch must declare its functions before use, there is no
+  Arduino prototype generation here):
+    g++ -std=gnu++11 -O2 -I extras/host -I src -x c++ MySketch.ino \
+        -x none extras/host/dr_replay.cpp -o replay
+
+  Add -DDR_HOST_BOARD_UNO to both for a capture from an Uno or Nano.
+
+  Run:
+    ./replay [capture.bin] [--step-us N] [--tail-ms N] [--outputs] [--bench]
+
+    --step-us N   Virtual time between loop() calls (default 100)
+    --tail-ms N   Keep running this long after the last record (default 1000)
+    --outputs     Log every output pin change to stdout
+    --bench       Report the host time spent in loop() to stderr
+
+  Without a capture the sketch runs for --tail-ms with idle inputs, which
+  makes the runner a plain update() benchmark.
+
+  Serial output and the output log share stdout, so two library versions
+  can be compared with a plain diff.
+******************************************************************************/
+
+#include "Arduino.h"
+
+#include <time.h>
+#include <vector>
+
+HardwareSerial Serial;
+
+/****** VIRTUAL HARDWARE *****************************************************/
+// Analog pins may lie past the digital ones, so cover both
+#define HOST_PINS (A0 + NUM_ANALOG_INPUTS > NUM_DIGITAL_PINS ? A0 + NUM_ANALOG_INPUTS : NUM_DIGITAL_PINS)
+
+static unsigned long long hostMicros = 0;
+static int inputValues[HOST_PINS];
+static int outputValues[HOST_PINS];
+static bool logOutputs = false;
+
+unsigned long millis() { return (unsigned long)(hostMicros / 1000); }
+unsigned long micros() { return (unsigned long)hostMicros; }
+void delay(unsigned long ms) { hostMicros += (unsigned long long)ms * 1000; }
+void delayMicroseconds(unsigned int us) { hostMicros += us; }
+
+void pinMode(uint8_t, uint8_t) {}
+
+static void logOutput(const char* kind, uint8_t pin, int value) {
+  if (pin >= HOST_PINS || outputValues[pin] == value) {
+    return;
+  }
+  outputValues[pin] = value;
+  if (logOutputs) {
+    printf("[%lu.%03lu] %s %u = %d\n", (unsigned long)(hostMicros / 1000),
+           (unsigned long)(hostMicros % 1000), kind, pin, value);
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t value) { logOutput("pin", pin, value); }
+void analogWrite(uint8_t pin, int value) { logOutput("pwm", pin, value); }
+
+void shiftOut(uint8_t dataPin, uint8_t, uint8_t, uint8_t value) {
+  if (logOutputs) {
+    printf("[%lu.%03lu] shift %u = 0x%02X\n", (unsigned long)(hostMicros / 1000),
+           (unsigned long)(hostMicros % 1000), dataPin, value);
+  }
+}
+
+int digitalRead(uint8_t pin) { return pin < HOST_PINS ? inputValues[pin] : LOW; }
+int analogRead(uint8_t pin) { return pin < HOST_PINS ? inputValues[pin] : 0; }
+
+// Deterministic so replays are repeatable
+static unsigned long randomState = 1;
+void randomSeed(unsigned long seed) { randomState = seed ? seed : 1; }
+long random(long max) {
+  randomState = randomState * 1103515245UL + 12345UL;
+  return max > 0 ? (long)((randomState >> 16) % (unsigned long)max) : 0;
+}
+long random(long min, long max) { return max > min ? min + random(max - min) : min; }
+
+/****** CAPTURE ***************************************************************/
+struct InputEvent {
+  unsigned long timeMs;
+  uint8_t pin;
+  int value;
+};
+
+static bool readVarint(const std::vector<uint8_t>& data, size_t& pos, unsigned long& value) {
+  value = 0;
+  for (byte shift = 0; pos < data.size() && shift < 35; shift += 7) {
+    uint8_t b = data[pos++];
+    value |= (unsigned long)(b & 0x7F) << shift;
+    if (!(b & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool loadCapture(const char* path, std::vector<InputEvent>& events) {
+  FILE* f = fopen(path, "rb");
+  if (f == NULL) {
+    fprintf(stderr, "ERROR: cannot open %s\n", path);
+    return false;
+  }
+  std::vector<uint8_t> data;
+  int c;
+  while ((c = fgetc(f)) != EOF) {
+    data.push_back((uint8_t)c);
+  }
+  fclose(f);
+
+  // Skip anything printed before recording started
+  size_t pos = 0;
+  while (pos + 4 <= data.size() && memcmp(&data[pos], "DRR1", 4) != 0) {
+    pos++;
+  }
+  if (pos + 4 > data.size()) {
+    fprintf(stderr, "ERROR: no DRR1 capture found in %s\n", path);
+    return false;
+  }
+  pos += 4;
+
+  // Pin numbers are only meaningful with the board's layout
+  if (pos >= data.size()) {
+    fprintf(stderr, "ERROR: truncated capture header in %s\n", path);
+    return false;
+  }
+  uint8_t boardA0 = data[pos++];
+  if (boardA0 != A0) {
+    fprintf(stderr, "ERROR: %s was recorded on a board with A0 = %u, but this runner was built with A0 = %u\n",
+            path, boardA0, (unsigned)A0);
+    if (boardA0 == 14 || boardA0 == 54) {
+      fprintf(stderr, "       rebuild %s -DDR_HOST_BOARD_UNO\n", boardA0 == 14 ? "with" : "without");
+    }
+    return false;
+  }
+
+  unsigned long now = 0;
+  while (pos < data.size()) {
+    unsigned long dt, value;
+    if (!readVarint(data, pos, dt) || pos >= data.size()) {
+      break;
+    }
+    uint8_t pin = data[pos++];
+    if (!readVarint(data, pos, value)) {
+      break;
+    }
+    now += dt;
+    InputEvent event = { now, pin, (int)value };
+    events.push_back(event);
+  }
+  return true;
+}
+
+/****** RUNNER ****************************************************************/
+static unsigned long long benchNanos = 0;
+static unsigned long benchLoops = 0;
+
+static unsigned long long hostNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void runUntil(unsigned long long targetMicros, unsigned long stepMicros) {
+  while (hostMicros < targetMicros) {
+    unsigned long long start = hostNanos();
+    loop();
+    benchNanos += hostNanos() - start;
+    benchLoops++;
+    hostMicros += stepMicros;
+  }
+}
+
+int main(int argc, char** argv) {
+  const char* path = NULL;
+  unsigned long stepMicros = 100;
+  unsigned long tailMs = 1000;
+  bool bench = false;
+
+  for (int i = 1; i < argc; i++) {
+    if (strcmp(argv[i], "--step-us") == 0 && i + 1 < argc) {
+      stepMicros = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--tail-ms") == 0 && i + 1 < argc) {
+      tailMs = strtoul(argv[++i], NULL, 10);
+    } else if (strcmp(argv[i], "--outputs") == 0) {
+      logOutputs = true;
+    } else if (strcmp(argv[i], "--bench") == 0) {
+      bench = true;
+    } else {
+      path = argv[i];
+    }
+  }
+  if (stepMicros == 0) {
+    fprintf(stderr, "usage: %s [capture.bin] [--step-us N] [--tail-ms N] [--outputs] [--bench]\n", argv[0]);
+    return 1;
+  }
+
+  std::vector<InputEvent> events;
+  if (path != NULL && !loadCapture(path, events)) {
+    return 1;
+  }
+
+  // Idle inputs until the capture says otherwise: pulled-up buttons read HIGH
+  for (int pin = 0; pin < HOST_PINS; pin++) {
+    inputValues[pin] = HIGH;
+    outputValues[pin] = -1;
+  }
+
+  setup();
+
+  bool dropped[256] = { false };
+  for (size_t i = 0; i < events.size(); i++) {
+    runUntil((unsigned long long)events[i].timeMs * 1000, stepMicros);
+    uint8_t pin = events[i].pin;
+    if (pin < HOST_PINS) {
+      inputValues[pin] = events[i].value;
+    } else if (!dropped[pin]) {
+      dropped[pin] = true;
+      fprintf(stderr, "WARNING: the capture has input pin %u, but this runner only has pins 0-%u; its changes are ignored\n",
+              pin, (unsigned)HOST_PINS - 1);
+    }
+  }
+  unsigned long lastMs = events.empty() ? 0 : events.back().timeMs;
+  runUntil((unsigned long long)(lastMs + tailMs) * 1000, stepMicros);
+
+  fflush(stdout);
+  if (bench) {
+    fprintf(stderr, "replayed %lu input changes over %lu ms: %lu loop() calls, %.1f ns per call\n",
+            (unsigned long)events.size(), lastMs + tailMs, benchLoops,
+            benchLoops ? (double)benchNanos / benchLoops : 0.0);
+  }
+  return 0;
+}
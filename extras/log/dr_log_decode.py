@@ -0,0 +1,120 @@
+#!/usr/bin/env python3
+"""
+DeviceReactor binary log decoder
+
+With DEVICE_REACTOR_LOG_BINARY defined, each debug message is sent as the
+line number of its DR_DEBUG_PRINT / DR_DEBUG_PRINTLN call in DeviceReactor.h
+plus, for messages that print a value, the raw value. This tool rebuilds the
+text from a string table generated from the same header.
+
+Usage:
+    python3 dr_log_decode.py src/DeviceReactor.h capture.bin
+    python3 dr_log_decode.py src/DeviceReactor.h --table     # dump the table
+
+The header must be the exact version that was compiled into the firmware,
+otherwise line numbers won't match.
+
+The firmware repeats the "DRL1" marker every DR_LOG_SYNC_RECORDS messages.
+Decoding starts at the first marker, and after an unknown id (bytes lost on
+the wire) it skips ahead to the next one.
+"""
+
+import ast
+import json
+import re
+import sys
+
+MAGIC = b"DRL1"
+SITE = re.compile(r"\bDR_DEBUG_PRINT(LN)?\((.*)\);")
+
+
+def build_table(header_path):
+    """Maps line number -> (newline, literal text or None for a value)."""
+    table = {}
+    with open(header_path, encoding="utf-8") as f:
+        for number, line in enumerate(f, 1):
+            if "#define" in line:
+                continue
+            match = SITE.search(line)
+            if not match:
+                continue
+            arg = match.group(2).strip()
+            text = ast.literal_eval(arg) if arg.startswith('"') else None
+            table[number] = (bool(match.group(1)), text, arg)
+    return table
+
+
+def read_varint(data, pos):
+    value = 0
+    shift = 0
+    while pos < len(data):
+        b = data[pos]
+        pos += 1
+        value |= (b & 0x7F) << shift
+        if not b & 0x80:
+            return value, pos
+        shift += 7
+    raise EOFError
+
+
+def decode(table, data, out):
+    start = data.find(MAGIC)
+    if start < 0:
+        sys.stderr.write("no DRL1 log found\n")
+        return 1
+    pos = start
+    markers = 0
+    while pos < len(data):
+        if data.startswith(MAGIC, pos):
+            pos += len(MAGIC)
+            markers += 1
+            continue
+        try:
+            record = pos
+            line, pos = read_varint(data, pos)
+            if line == 0:
+                dropped, pos = read_varint(data, pos)
+                out.write("[debug: %d messages dropped]\n" % dropped)
+                continue
+            site = table.get(line)
+            if site is None:
+                if markers == 1:
+                    # Still right after the first marker, so the data is good
+                    # and the table is not
+                    sys.stderr.write("unknown log id %d at byte %d (header version mismatch?)\n" % (line, record))
+                    return 1
+                resync = data.find(MAGIC, record + 1)
+                if resync < 0:
+                    break
+                out.write("[log: lost sync, skipped %d bytes]\n" % (resync - record))
+                pos = resync
+                continue
+            newline, text, _ = site
+            if text is None:
+                raw, pos = read_varint(data, pos)
+                text = str((raw >> 1) ^ -(raw & 1))
+        except EOFError:
+            break
+        out.write(text)
+        if newline:
+            out.write("\n")
+    return 0
+
+
+def main():
+    if len(sys.argv) != 3:
+        sys.stderr.write("usage: dr_log_decode.py DeviceReactor.h (capture.bin | --table)\n")
+        return 1
+    table = build_table(sys.argv[1])
+    if sys.argv[2] == "--table":
+        json.dump({str(k): {"println": v[0], "text": v[1], "value": None if v[1] is not None else v[2]}
+                   for k, v in sorted(table.items())}, sys.stdout, indent=1)
+        sys.stdout.write("\n")
+        return 0
+    with open(sys.argv[2], "rb") as f:
+        data = f.read()
+    return decode(table, data, sys.stdout)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+"""
+DeviceReactor trace decoder
+
+Turns the binary output of device.traceDump() into Chrome trace JSON, which
+can be opened in chrome://tracing or https://ui.perfetto.dev.
+
+Capture the raw serial bytes to a file first, for example:
+    python3 -m serial.tools.miniterm --raw /dev/ttyUSB0 115200 > capture.bin
+or
+    cat /dev/ttyUSB0 > capture.bin
+
+Then:
+    python3 dr_trace_decode.py capture.bin > trace.json
+
+Any text printed around the dumps is ignored, and every dump found in the
+capture is decoded. Dumps are placed on the timeline by their micros() time.
+"""
+
+import json
+import struct
+import sys
+
+MAGIC = b"DRT1"
+HEADER = struct.Struct("<BHII")      # record size, count, overwritten, oldest time
+RECORD = struct.Struct("<HBBBBh")    # dt, source, index, event, reserved, value
+
+# Must match DR_SRC_* in DeviceReactor.h. New sources are only ever appended,
+# so captures from older builds still decode correctly.
+SOURCES = [
+    "update", "leds", "ledGroups", "buttons", "encoders", "analog",
+    "intervals", "pixelStrips", "shift", "charlie", "fastOutput",
+    "buttonCb", "encoderCb", "analogCb", "intervalCb", "pixelCb", "sketch",
+    "ledCb", "sequencers", "sequenceCb",
+]
+
+# Must match DR_EV_* in DeviceReactor.h
+EV_BEGIN, EV_END, EV_TIME, EV_USER = 0, 1, 10, 128
+EVENTS = {
+    2: "press", 3: "release", 4: "cw", 5: "ccw", 6: "value",
+    7: "zone", 8: "fire", 9: "show",
+}
+
+INVALID_HANDLE = 255
+
+
+def source_name(source):
+    if source < len(SOURCES):
+        return SOURCES[source]
+    return "source%d" % source
+
+
+def decode_dump(data, offset, out):
+    """Decodes one dump starting at offset. Returns the offset after it."""
+    start = offset + len(MAGIC)
+    if start + HEADER.size > len(data):
+        return start
+    size, count, overwritten, oldest = HEADER.unpack_from(data, start)
+    body = start + HEADER.size
+    if size != RECORD.size or body + count * size > len(data):
+        return start  # Not a real dump, keep scanning
+
+    if overwritten:
+        out.append({"name": "%d records overwritten" % overwritten, "ph": "i",
+                    "s": "g", "ts": oldest, "pid": 0, "tid": 0})
+
+    now = oldest
+    depth = 0  # Open B events; a wrapped ring can start with orphaned ends
+    for i in range(count):
+        dt, source, index, event, _, value = RECORD.unpack_from(data, body + i * size)
+        # The header already holds the oldest record's full time
+        if i > 0:
+            now += dt
+            if event == EV_TIME:
+                now += value << 16
+        if event == EV_TIME:
+            continue
+
+        name = source_name(source)
+        args = {}
+        if index != INVALID_HANDLE:
+            name = "%s[%d]" % (name, index)
+            args["index"] = index
+
+        if event == EV_BEGIN:
+            depth += 1
+            out.append({"name": name, "ph": "B", "ts": now, "pid": 0, "tid": 0, "args": args})
+        elif event == EV_END:
+            if depth == 0:
+                continue
+            depth -= 1
+            out.append({"ph": "E", "ts": now, "pid": 0, "tid": 0})
+        else:
+            if event >= EV_USER:
+                label = "user%d" % (event - EV_USER)
+            else:
+                label = EVENTS.get(event, "event%d" % event)
+            args["value"] = value
+            out.append({"name": "%s %s" % (name, label), "ph": "i", "s": "t",
+                        "ts": now, "pid": 0, "tid": 0, "args": args})
+
+    return body + count * size
+
+
+def main():
+    if len(sys.argv) != 2:
+        sys.stderr.write("usage: dr_trace_decode.py capture.bin > trace.json\n")
+        return 1
+
+    with open(sys.argv[1], "rb") as f:
+        data = f.read()
+
+    events = []
+    dumps = 0
+    offset = data.find(MAGIC)
+    while offset >= 0:
+        after = decode_dump(data, offset, events)
+        if after > offset + len(MAGIC):
+            dumps += 1
+        offset = data.find(MAGIC, after)
+
+    sys.stderr.write("decoded %d dump(s), %d events\n" % (dumps, len(events)))
+    json.dump({"traceEvents": events, "displayTimeUnit": "ms"}, sys.stdout)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -49,286 +49,1435 @@
   #define MAX_ZONES_PER_SENSOR 0
 #endif
 
-/****** END CONFIGURATION ****************************************************/
+#ifndef TOTAL_BINDINGS
+  #define TOTAL_BINDINGS 0
+#endif
 
-// Invalid handle constant
-#define INVALID_HANDLE 255
+#ifndef TOTAL_HYSTERESIS_CONTROLLERS
+  #define TOTAL_HYSTERESIS_CONTROLLERS 0
+#endif
 
-/****** DEBUG MACROS ********************************************************/
-// Usage: #define DEVICE_REACTOR_DEBUG Serial before including this library
-#ifdef DEVICE_REACTOR_DEBUG
-  #define DR_DEBUG_PRINT(x)   DEVICE_REACTOR_DEBUG.print(x)
-  #define DR_DEBUG_PRINTLN(x) DEVICE_REACTOR_DEBUG.println(x)
-#else
-  #define DR_DEBUG_PRINT(x)
-  #define DR_DEBUG_PRINTLN(x)
+#ifndef TOTAL_RADIO_GROUPS
+  #define TOTAL_RADIO_GROUPS 0
 #endif
-/****** END DEBUG MACROS ****************************************************/
 
-// Callback type definitions
-typedef void (*basicCallback)();
-typedef void (*byteParamCallback)(byte);
-typedef void (*intParamCallback)(int);
+#ifndef MAX_RADIO_OPTIONS
+  #define MAX_RADIO_OPTIONS 8
+#endif
 
-/****** BUTTON MODES *********************************************************/
-#define BUTTON_PRESS_HIGH 0
-#define BUTTON_PRESS_LOW 1
-#define BUTTON_INPUT_PULLUP 2
+#ifndef TOTAL_SEQUENCERS
+  #define TOTAL_SEQUENCERS 0
+#endif
 
-/*****************************************************************************
- * INTERVAL CLASS
- *****************************************************************************/
-#if TOTAL_INTERVALS > 0
-  class Device;  // Forward declaration
+#ifndef TOTAL_SUBSCRIBERS
+  #define TOTAL_SUBSCRIBERS 0
+#endif
 
-  class IntervalHandle {
-    public:
-      IntervalHandle(Device* dev, byte idx) : device(dev), index(idx) {}
+#ifndef MAX_SUBSCRIBERS_PER_TOPIC
+  #define MAX_SUBSCRIBERS_PER_TOPIC 4
+#endif
 
-      IntervalHandle& withMessage(byte msg);
-      void stop();
-      void pause();
-      void resume();
+#ifndef TOTAL_PIXEL_STRIPS
+  #define TOTAL_PIXEL_STRIPS 0
+#endif
 
-    private:
-      Device* device;
-      byte index;
-      friend class Device;
-  };
+#ifndef MAX_PIXELS_PER_STRIP
+  #define MAX_PIXELS_PER_STRIP 0
+#endif
 
-  class Interval {
-    public:
-      Interval() {
-        // Initialize all slots to inactive and unpaused
-        for (byte i = 0; i < TOTAL_INTERVALS; i++) {
-          counts[i] = -1;
-          paused[i] = false;
-        }
-      }
+#ifndef TOTAL_LED_GROUPS
+  #define TOTAL_LED_GROUPS 0
+#endif
 
-      byte add(byteParamCallback callback, unsigned long wait, int count, byte msg) {
-        // Find an available slot for reuse
-        byte slot = findSlot();
+#ifndef MAX_LEDS_PER_GROUP
+  #define MAX_LEDS_PER_GROUP 8
+#endif
 
-        if (slot >= TOTAL_INTERVALS) {
-          Serial.println("FATAL ERROR: All interval slots used. Increase TOTAL_INTERVALS. Halting.");
-          while(1);
-        }
+#ifndef TOTAL_SHIFT_REGISTERS
+  #define TOTAL_SHIFT_REGISTERS 0
+#endif
 
-        #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINT("New interval on slot ");
-          DR_DEBUG_PRINT(slot);
-          DR_DEBUG_PRINT(" with msg=");
-          DR_DEBUG_PRINTLN(msg);
-        #endif
+#ifndef TOTAL_CHARLIE_ARRAYS
+  #define TOTAL_CHARLIE_ARRAYS 0
+#endif
 
-        // Fully initialize the slot to prevent stale data issues
-        callbacks[slot] = callback;
-        waits[slot] = wait;
-        counts[slot] = count;
-        msgs[slot] = msg;
-        lastRuns[slot] = millis();
-        paused[slot] = false;  // Ensure slot is not paused
-        return slot;
-      }
+#ifndef MAX_CHARLIE_PINS
+  #define MAX_CHARLIE_PINS 5
+#endif
 
-      void clear(byte index) {
-        if (index < TOTAL_INTERVALS) {
-          // Mark as inactive (stops it from running and makes slot available for reuse)
-          // Note: We clear the callback pointer first to prevent race conditions if
-          // clear() is called from within a callback during update() iteration
-          callbacks[index] = nullptr;  // Clear callback to prevent stale function pointers
-          counts[index] = -1;
-          paused[index] = false;  // Reset paused state for slot reuse
-          waits[index] = 0;
-          msgs[index] = 0;
-          lastRuns[index] = 0;
+#if TOTAL_SHIFT_REGISTERS > 32
+  #error "TOTAL_SHIFT_REGISTERS is limited to 32 chips (256 outputs, byte-addressed)"
+#endif
+
+#if MAX_RADIO_OPTIONS > 16
+  #error "MAX_RADIO_OPTIONS is limited to 16 options per radio group"
+#endif
+
+#if TOTAL_PIXEL_STRIPS > 0 && MAX_PIXELS_PER_STRIP == 0
+  #error "TOTAL_PIXEL_STRIPS requires MAX_PIXELS_PER_STRIP to be defined"
+#endif
+
+/****** END CONFIGURATION ****************************************************/
+
+// Hardware SPI is opt-in so sketches that don't need it don't pull in SPI.h
+// Usage: #define DEVICE_REACTOR_USE_SPI before including this library
+#ifdef DEVICE_REACTOR_USE_SPI
+  #include <SPI.h>
+#endif
+
+// Fast output batches on/off LED writes into per-port register writes (AVR only,
+// other architectures keep using digitalWrite())
+// Usage: #define DEVICE_REACTOR_FAST_OUTPUT before including this library
+#if defined(DEVICE_REACTOR_FAST_OUTPUT) && defined(__AVR__)
+  #define DR_FAST_OUTPUT_ENABLED
+#endif
+
+// Invalid handle constant
+#define INVALID_HANDLE 255
+
+// State shared across the library (diagnostics buffers, lookup tables) lives
+// in function-local statics rather than at namespace scope, so the header can
+// be included from more than one translation unit of a sketch.
+
+/****** DEBUG MACROS ********************************************************/
+// Usage: #define DEVICE_REACTOR_DEBUG Serial before including this library
+//
+// Messages are queued in a RAM buffer and drained at the end of each
+// Device::update(), only as fast as the port can take them without blocking.
+// Define DEVICE_REACTOR_DEBUG_DIRECT to print straight to the port instead.
+//
+// Define DEVICE_REACTOR_LOG_BINARY as well to send each message as its source
+// line number plus the raw value instead of text; decode the output with
+// extras/log/dr_log_decode.py. Format: "DRL1", then per message a varint line
+// number followed, for messages that print a value, by a zigzag varint value.
+// Line 0 reports dropped messages. "DRL1" is repeated every DR_LOG_SYNC_RECORDS
+// messages so a reader that starts late or loses bytes can find its place.
+#if defined(DEVICE_REACTOR_LOG_BINARY) && defined(DEVICE_REACTOR_DEBUG_DIRECT)
+  #error "DEVICE_REACTOR_LOG_BINARY needs the buffered debug output, remove DEVICE_REACTOR_DEBUG_DIRECT"
+#endif
+
+#if defined(DEVICE_REACTOR_DEBUG) && defined(DEVICE_REACTOR_DEBUG_DIRECT)
+  #define DR_DEBUG_PRINT(x)   DEVICE_REACTOR_DEBUG.print(x)
+  #define DR_DEBUG_PRINTLN(x) DEVICE_REACTOR_DEBUG.println(x)
+#elif defined(DEVICE_REACTOR_DEBUG)
+  #ifndef DR_DEBUG_BUFFER
+    #ifdef __AVR__
+      #define DR_DEBUG_BUFFER 128
+    #else
+      #define DR_DEBUG_BUFFER 512
+    #endif
+  #endif
+
+  // Most bytes handed to the port per update() pass
+  #ifndef DR_DEBUG_DRAIN
+    #define DR_DEBUG_DRAIN 16
+  #endif
+
+  // Binary log messages between two "DRL1" sync markers (1-255)
+  #ifndef DR_LOG_SYNC_RECORDS
+    #define DR_LOG_SYNC_RECORDS 32
+  #endif
+  #if DR_LOG_SYNC_RECORDS < 1 || DR_LOG_SYNC_RECORDS > 255
+    #error "DR_LOG_SYNC_RECORDS must be between 1 and 255"
+  #endif
+
+  class DebugBuffer : public Print {
+    public:
+      unsigned long droppedTotal = 0;
+      bool running = false;  // Set by the first Device::update()
+
+      size_t write(uint8_t c) {
+        uint16_t next = (head + 1) % DR_DEBUG_BUFFER;
+        if (overflow || next == tail) {
+          overflow = true;
+          return 0;
         }
+        buffer[head] = c;
+        head = next;
+        return 1;
       }
-
-      void setMessage(byte index, byte msg) {
-        // Bounds check and verify slot is active
-        if (index >= TOTAL_INTERVALS) {
-          #ifdef DEVICE_REACTOR_DEBUG
-            DR_DEBUG_PRINT("ERROR: Invalid interval index ");
-            DR_DEBUG_PRINTLN(index);
-          #endif
+      using Print::write;
+
+      // Queues a whole message or nothing, a full buffer never blocks.
+      // Before the first update() (in setup()) it prints directly instead.
+      template <typename T>
+      void message(T value, bool newline) {
+        if (!running) {
+          flush(DEVICE_REACTOR_DEBUG);
+          DEVICE_REACTOR_DEBUG.print(value);
+          if (newline) {
+            DEVICE_REACTOR_DEBUG.println();
+          }
           return;
         }
-        if (counts[index] >= 0) {
-          msgs[index] = msg;
+        uint16_t mark = head;
+        overflow = false;
+        print(value);
+        if (newline) {
+          println();
+        }
+        if (overflow) {
+          head = mark;
+          overflow = false;
+          dropped++;
+          droppedTotal++;
         }
       }
 
-      void pause(byte index) {
-        // Bounds check and verify slot is active
-        if (index >= TOTAL_INTERVALS) {
-          #ifdef DEVICE_REACTOR_DEBUG
-            DR_DEBUG_PRINT("ERROR: Invalid interval index ");
-            DR_DEBUG_PRINTLN(index);
-          #endif
+      // Binary log record, queued as a whole or dropped like message()
+      void record(uint16_t id, bool hasValue, long value) {
+        if (!running) {
+          flush(DEVICE_REACTOR_DEBUG);
+          encode(DEVICE_REACTOR_DEBUG, id, hasValue, value);
           return;
         }
-        if (counts[index] >= 0) {
-          paused[index] = true;
-          #ifdef DEVICE_REACTOR_DEBUG
-            DR_DEBUG_PRINT("Interval ");
-            DR_DEBUG_PRINT(index);
-            DR_DEBUG_PRINTLN(" paused");
-          #endif
+        uint16_t mark = head;
+        overflow = false;
+        encode(*this, id, hasValue, value);
+        if (overflow) {
+          head = mark;
+          overflow = false;
+          dropped++;
+          droppedTotal++;
         }
       }
 
-      void resume(byte index) {
-        // Bounds check and verify slot is active
-        if (index >= TOTAL_INTERVALS) {
-          #ifdef DEVICE_REACTOR_DEBUG
-            DR_DEBUG_PRINT("ERROR: Invalid interval index ");
-            DR_DEBUG_PRINTLN(index);
-          #endif
-          return;
-        }
-        if (counts[index] >= 0) {
-          paused[index] = false;
-          // Reset the timer to prevent immediate firing after resume
-          lastRuns[index] = millis();
-          #ifdef DEVICE_REACTOR_DEBUG
-            DR_DEBUG_PRINT("Interval ");
-            DR_DEBUG_PRINT(index);
-            DR_DEBUG_PRINTLN(" resumed");
+      void drain(Print& out, unsigned int limit) {
+        if (dropped > 0) {
+          // Tell the reader something is missing, once there is room again
+          uint16_t mark = head;
+          overflow = false;
+          #ifdef DEVICE_REACTOR_LOG_BINARY
+            encode(*this, 0, true, dropped);
+          #else
+            print("[debug: ");
+            print(dropped);
+            println(" messages dropped]");
           #endif
+          if (overflow) {
+            head = mark;
+            overflow = false;
+          } else {
+            dropped = 0;
+          }
         }
-      }
-
-      void update() {
-        for (byte i = 0; i < TOTAL_INTERVALS; i++) {
-          // Only process active intervals (-1 is inactive) and skip paused intervals
-          // Check callback is not null to prevent race conditions with clear()
-          if (counts[i] >= 0 && !paused[i] && callbacks[i] != nullptr) {
-            // Check if the time since the last run is >= the wait
-            // Note: (millis() - lastRuns[i]) handles millis() rollover correctly
-            if ((millis() - lastRuns[i]) >= waits[i]) {
-              // Store callback locally in case clear() is called during execution
-              byteParamCallback localCallback = callbacks[i];
-              byte localMsg = msgs[i];
-
-              // Decrement count AFTER callback to prevent double execution
-              localCallback(localMsg); // Run the callback function
-              lastRuns[i] = millis(); // Update the last run
 
-              // Now update count state after callback (check callback still valid)
-              if (counts[i] > 0 && callbacks[i] != nullptr) {
-                counts[i]--; // Decrement the count
-                // Check if the count has reached 0
-                if (counts[i] == 0) {
-                  counts[i] = -1; // Mark as inactive after final execution
-                }
-              }
-            }
-          }
+        int room = out.availableForWrite();
+        if (room < 0) {
+          room = 0;
+        }
+        if (limit > (unsigned int)room) {
+          limit = room;
+        }
+        while (limit > 0 && tail != head) {
+          out.write(buffer[tail]);
+          tail = (tail + 1) % DR_DEBUG_BUFFER;
+          limit--;
         }
       }
 
-      #ifdef DEVICE_REACTOR_DEBUG
-        void printStatus() {
-          DR_DEBUG_PRINTLN("INTERVAL DEBUG:");
-          for (byte i = 0; i < TOTAL_INTERVALS; i++) {
-            if (counts[i] >= 0) {
-              DR_DEBUG_PRINT("(");
-              DR_DEBUG_PRINT(i);
-              DR_DEBUG_PRINT(") Count:");
-              DR_DEBUG_PRINT(counts[i]);
-              DR_DEBUG_PRINT(" Wait:");
-              DR_DEBUG_PRINT(waits[i]);
-              DR_DEBUG_PRINT(" Msg:");
-              DR_DEBUG_PRINTLN(msgs[i]);
-            }
-          }
-          DR_DEBUG_PRINTLN("-------------------------");
+      // Blocking: hands everything queued to the port
+      void flush(Print& out) {
+        while (tail != head) {
+          out.write(buffer[tail]);
+          tail = (tail + 1) % DR_DEBUG_BUFFER;
         }
-      #endif
+      }
 
     private:
-      byteParamCallback callbacks[TOTAL_INTERVALS];
-      int counts[TOTAL_INTERVALS];  // -1 = inactive, 0 = infinite, >0 = remaining
-      unsigned long waits[TOTAL_INTERVALS];
-      unsigned long lastRuns[TOTAL_INTERVALS];
-      byte msgs[TOTAL_INTERVALS];
-      bool paused[TOTAL_INTERVALS];
+      byte buffer[DR_DEBUG_BUFFER];
+      uint16_t head = 0;
+      uint16_t tail = 0;
+      bool overflow = false;
+      byte sinceSync = 0;         // Binary log records since the last marker
+      unsigned long dropped = 0;  // Not yet reported in the output
+
+      void encode(Print& out, uint16_t id, bool hasValue, long value) {
+        if (sinceSync == 0) {
+          out.write((const uint8_t*)"DRL1", 4);
+        }
+        writeVarint(out, id);
+        if (hasValue) {
+          // Zigzag keeps small negative numbers short
+          writeVarint(out, ((unsigned long)value << 1) ^ (unsigned long)(value >> 31));
+        }
+        if (!overflow) {
+          sinceSync = (sinceSync + 1 < DR_LOG_SYNC_RECORDS) ? sinceSync + 1 : 0;
+        }
+      }
 
-      // Find an empty interval slot
-      byte findSlot() {
-        for (byte i = 0; i < TOTAL_INTERVALS; i++) {
-          if (counts[i] == -1) {
-            return i;
-          }
+      static void writeVarint(Print& out, unsigned long value) {
+        while (value >= 0x80) {
+          out.write((uint8_t)(value | 0x80));
+          value >>= 7;
         }
-        // No empty slot found
-        return INVALID_HANDLE;
+        out.write((uint8_t)value);
       }
   };
-#endif
-
-/*****************************************************************************
- * ANALOG SENSOR CLASS
- *****************************************************************************/
-#if TOTAL_ANALOG_SENSORS > 0
-  class AnalogSensor {
-    public:
-      // Sprint 5: Preset enum for common configurations
-      enum Preset {
-        RAW_DATA,              // No processing, raw 0-1023 values
-        POT_FOR_LED,           // Smooth, continuous 0-255 for analogWrite
-        POT_FOR_SERVO,         // Smooth, continuous 0-180 for servo control
-        POT_FOR_PERCENTAGE,    // Stable 0-100 in steps of 5
-        SWITCH_5_POSITION      // Heavy 5-position switch (0-4)
-      };
 
-      // Sprint 5: Preset configuration structure
-      struct PresetConfig {
-        byte smoothing_samples;
-        int output_min;
-        int output_max;
-        int quantize_step;      // Q value
-        int hysteresis_amount;  // H value
-        int change_threshold;   // T value for non-quantized mode
-      };
+  // Shared by every component class
+  inline DebugBuffer& drDebug() {
+    static DebugBuffer debug;
+    return debug;
+  }
 
-      // Zone structure for zone-based state management
-      struct Zone {
-        byte id;
-        int min_val;
-        int max_val;
-      };
+  #ifdef DEVICE_REACTOR_LOG_BINARY
+    // Text arguments are never sent (or kept), the decoder knows them by line
+    inline void drLog(uint16_t id, const char*) {
+      drDebug().record(id, false, 0);
+    }
 
-      // Sprint 5: Static preset configurations array
-      static const PresetConfig preset_configs[];
+    template <typename T>
+    inline void drLog(uint16_t id, T value) {
+      drDebug().record(id, true, (long)value);
+    }
 
-      byte pin;
+    #define DR_DEBUG_PRINT(x)   drLog(__LINE__, x)
+    #define DR_DEBUG_PRINTLN(x) drLog(__LINE__, x)
+  #else
+    #define DR_DEBUG_PRINT(x)   drDebug().message(x, false)
+    #define DR_DEBUG_PRINTLN(x) drDebug().message(x, true)
+  #endif
+  #define DR_DEBUG_BUFFERED
+#else
+  #define DR_DEBUG_PRINT(x)
+  #define DR_DEBUG_PRINTLN(x)
+#endif
+/****** END DEBUG MACROS ****************************************************/
 
-      void init(byte newPin) {
-        if (initialized) {
-          Serial.println("WARNING: AnalogSensor already initialized. Ignoring.");
-          return;
-        }
-        pin = newPin;
-        initialized = true;
-        #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINT("Setup Analog Sensor on pin ");
-          DR_DEBUG_PRINTLN(pin);
-        #endif
+/****** COMPONENT SOURCES ***************************************************/
+// Identifies which part of Device::update() is running, for diagnostics
+#define DR_SRC_UPDATE        0   // The whole Device::update() call
+#define DR_SRC_LEDS          1
+#define DR_SRC_LED_GROUPS    2
+#define DR_SRC_BUTTONS       3
+#define DR_SRC_ENCODERS      4
+#define DR_SRC_ANALOG        5
+#define DR_SRC_INTERVALS     6
+#define DR_SRC_PIXELS        7
+#define DR_SRC_SHIFT         8
+#define DR_SRC_CHARLIE       9
+#define DR_SRC_FAST_OUTPUT  10
+// User callbacks (their time is also included in the owning component)
+#define DR_SRC_BUTTON_CB    11
+#define DR_SRC_ENCODER_CB   12
+#define DR_SRC_ANALOG_CB    13
+#define DR_SRC_INTERVAL_CB  14
+#define DR_SRC_PIXEL_CB     15
+// Sketch code running between two Device::update() calls
+#define DR_SRC_SKETCH       16
+// Later sources are appended so recorded traces keep their meaning
+#define DR_SRC_LED_CB       17
+#define DR_SRC_SEQUENCERS   18
+#define DR_SRC_SEQUENCE_CB  19
+#define DR_SRC_COUNT        20
+
+/****** PROFILING ***********************************************************/
+// Usage: #define DEVICE_REACTOR_PROFILE before including this library, then
+// call device.profileReport(Serial) whenever you want a summary
+#ifdef DEVICE_REACTOR_PROFILE
+  // Tick source: DWT cycle counter on Cortex-M3/M4/M7, clock_gettime() on a
+  // host build, micros() everywhere else
+  #if defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__)
+    #define DR_PROFILE_UNIT "cycles"
+    #define DR_PROFILE_DEFAULT_SHIFT 4
+    #define DR_DEMCR      (*(volatile uint32_t*)0xE000EDFC)
+    #define DR_DWT_CTRL   (*(volatile uint32_t*)0xE0001000)
+    #define DR_DWT_CYCCNT (*(volatile uint32_t*)0xE0001004)
+    inline void drProfileStart() {
+      DR_DEMCR |= (1UL << 24);  // TRCENA
+      DR_DWT_CYCCNT = 0;
+      DR_DWT_CTRL |= 1;         // CYCCNTENA
+    }
+    // Some cores reset the debug unit after static constructors have run,
+    // so update() turns the counter back on when it finds it stopped
+    inline void drProfileKeepRunning() {
+      if (!(DR_DWT_CTRL & 1)) {
+        drProfileStart();
       }
-
-      AnalogSensor& inputRange(int newMin, int newMax) {
-        inputMin = newMin;
-        inputMax = newMax;
-        return *this;
+    }
+    inline uint32_t drProfileNow() { return DR_DWT_CYCCNT; }
+  #elif !defined(ARDUINO)
+    #include <time.h>
+    #define DR_PROFILE_UNIT "ns"
+    #define DR_PROFILE_DEFAULT_SHIFT 6
+    inline void drProfileStart() {}
+    inline void drProfileKeepRunning() {}
+    inline uint32_t drProfileNow() {
+      struct timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec);
+    }
+  #else
+    #define DR_PROFILE_UNIT "us"
+    #define DR_PROFILE_DEFAULT_SHIFT 2  // micros() has 4us resolution on 16MHz AVR
+    inline void drProfileStart() {}
+    inline void drProfileKeepRunning() {}
+    inline uint32_t drProfileNow() { return micros(); }
+  #endif
+
+  // Histogram bucket i counts samples below (1 << i) << DR_PROFILE_SHIFT ticks,
+  // the last bucket counts everything above
+  #ifndef DR_PROFILE_BUCKETS
+    #ifdef __AVR__
+      #define DR_PROFILE_BUCKETS 8
+    #else
+      #define DR_PROFILE_BUCKETS 16
+    #endif
+  #endif
+
+  #ifndef DR_PROFILE_SHIFT
+    #define DR_PROFILE_SHIFT DR_PROFILE_DEFAULT_SHIFT
+  #endif
+
+  struct ProfileStat {
+    uint32_t count;
+    uint32_t minTicks;
+    uint32_t maxTicks;
+    uint64_t totalTicks;
+    uint16_t histogram[DR_PROFILE_BUCKETS];
+
+    void add(uint32_t ticks) {
+      if (count == 0 || ticks < minTicks) {
+        minTicks = ticks;
       }
-
-      AnalogSensor& outputRange(int newMin, int newMax) {
-        outputMin = newMin;
-        outputMax = newMax;
-        return *this;
+      if (ticks > maxTicks) {
+        maxTicks = ticks;
+      }
+      count++;
+      totalTicks += ticks;
+
+      byte bucket = 0;
+      for (uint32_t scaled = ticks >> DR_PROFILE_SHIFT; scaled && bucket < DR_PROFILE_BUCKETS - 1; scaled >>= 1) {
+        bucket++;
+      }
+      if (histogram[bucket] < 0xFFFF) {  // Saturate rather than wrap
+        histogram[bucket]++;
+      }
+    }
+  };
+
+  // One table shared by every component class
+  inline ProfileStat* drProfileStats() {
+    static ProfileStat stats[DR_SRC_COUNT];
+    return stats;
+  }
+
+  #define DR_PROFILE_BEGIN(name)     uint32_t name = drProfileNow()
+  #define DR_PROFILE_END(name, src)  drProfileStats()[src].add(drProfileNow() - name)
+#else
+  #define DR_PROFILE_BEGIN(name)
+  #define DR_PROFILE_END(name, src)
+#endif
+/****** END PROFILING *******************************************************/
+
+// Callback type definitions
+typedef void (*basicCallback)();
+typedef void (*byteParamCallback)(byte);
+typedef void (*intParamCallback)(int);
+typedef void (*pixelFrameCallback)(const byte* grb, unsigned int count);
+typedef void (*overrunCallback)(unsigned long elapsedUs, byte source, byte index);
+
+// Context callbacks also get the component's handle and a pointer supplied at
+// registration, so one handler can serve many components without a lookup
+typedef void (*contextCallback)(byte handle, void* ctx);
+typedef void (*contextByteCallback)(byte handle, byte value, void* ctx);
+typedef void (*contextIntCallback)(byte handle, int value, void* ctx);
+typedef void (*contextStepCallback)(byte handle, byte target, byte arg, void* ctx);
+typedef void (*contextFrameCallback)(byte handle, const byte* grb, unsigned int count, void* ctx);
+
+// Fixed-size callable: a free function, a captureless lambda, or a member
+// function bound to an object. Two pointers inline, no heap, no virtuals.
+template <typename Signature>
+class Delegate;
+
+template <typename... Args>
+class Delegate<void(Args...)> {
+  public:
+    typedef void (*Function)(Args...);
+    typedef void (*Stub)(void*, Args...);
+
+    Delegate() : stub(nullptr) {
+      target.function = nullptr;
+    }
+
+    Delegate(Function function) : stub(nullptr) {
+      target.function = function;
+    }
+
+    // Captureless lambdas, through their conversion to a function pointer
+    template <typename Lambda>
+    Delegate(Lambda lambda) : Delegate(static_cast<Function>(lambda)) {}
+
+    // e.g. Delegate<void(int)>::bind<Mixer, &Mixer::setVolume>(&mixer),
+    // or DR_BIND(&Mixer::setVolume, &mixer) without repeating the types
+    template <class T, void (T::*Method)(Args...)>
+    static Delegate bind(T* object) {
+      return Delegate(object, &callMember<T, Method>);
+    }
+
+    template <class T, void (T::*Method)(Args...) const>
+    static Delegate bind(const T* object) {
+      return Delegate(const_cast<T*>(object), &callConstMember<T, Method>);
+    }
+
+    explicit operator bool() const {
+      return stub != nullptr || target.function != nullptr;
+    }
+
+    void operator()(Args... args) const {
+      if (stub) {
+        stub(target.object, args...);
+      } else {
+        target.function(args...);
+      }
+    }
+
+  private:
+    union {
+      void* object;
+      Function function;
+    } target;
+    Stub stub;  // Set for member functions; the method call is inlined into it
+
+    Delegate(void* object, Stub memberStub) : stub(memberStub) {
+      target.object = object;
+    }
+
+    template <class T, void (T::*Method)(Args...)>
+    static void callMember(void* object, Args... args) {
+      (static_cast<T*>(object)->*Method)(args...);
+    }
+
+    template <class T, void (T::*Method)(Args...) const>
+    static void callConstMember(void* object, Args... args) {
+      (static_cast<const T*>(object)->*Method)(args...);
+    }
+
+    template <typename...> friend class CallbackSlot;
+};
+
+// Recovers the class and signature from a member pointer for DR_BIND
+template <typename M, M Method>
+struct DelegateMethod;
+
+template <class T, typename... Args, void (T::*Method)(Args...)>
+struct DelegateMethod<void (T::*)(Args...), Method> {
+  static Delegate<void(Args...)> bind(T* object) {
+    return Delegate<void(Args...)>::template bind<T, Method>(object);
+  }
+};
+
+template <class T, typename... Args, void (T::*Method)(Args...) const>
+struct DelegateMethod<void (T::*)(Args...) const, Method> {
+  static Delegate<void(Args...)> bind(const T* object) {
+    return Delegate<void(Args...)>::template bind<T, Method>(object);
+  }
+};
+
+#define DR_BIND(method, object) DelegateMethod<decltype(method), method>::bind(object)
+
+// Storage for one component callback: a delegate or a context callback in the
+// same slot, so dispatch is still a single indirect call
+template <typename... Args>
+class CallbackSlot {
+  public:
+    typedef void (*Plain)(Args...);
+    typedef void (*WithContext)(byte, Args..., void*);
+    typedef void (*Member)(void*, Args...);
+
+    CallbackSlot() {}
+    CallbackSlot(const Delegate<void(Args...)>& callback) { set(callback); }
+    CallbackSlot(WithContext callback, void* ctx) { set(callback, ctx); }
+
+    void set(const Delegate<void(Args...)>& callback) {
+      if (callback.stub) {
+        fn.member = callback.stub;
+        context = callback.target.object;
+        mode = MEMBER;
+      } else {
+        fn.plain = callback.target.function;
+        mode = fn.plain ? PLAIN : NONE;
+      }
+    }
+
+    void set(WithContext callback, void* ctx) {
+      fn.withContext = callback;
+      context = ctx;
+      mode = callback ? CONTEXT : NONE;
+    }
+
+    void clear() {
+      mode = NONE;
+    }
+
+    bool isSet() const {
+      return mode != NONE;
+    }
+
+    void operator()(byte handle, Args... args) const {
+      if (mode == MEMBER) {
+        fn.member(context, args...);
+      } else if (mode == CONTEXT) {
+        fn.withContext(handle, args..., context);
+      } else {
+        fn.plain(args...);
+      }
+    }
+
+  private:
+    enum : byte { NONE, PLAIN, CONTEXT, MEMBER };
+    union {
+      Plain plain;
+      WithContext withContext;
+      Member member;
+    } fn;
+    void* context = nullptr;
+    byte mode = NONE;
+};
+
+/****** EVENT BUS ***********************************************************/
+// Usage: #define TOTAL_SUBSCRIBERS n before including this library, route a
+// component with .publishTo(topic), then device.subscribe(topic, handler)
+#define DR_NO_TOPIC 255
+
+#if TOTAL_SUBSCRIBERS > 0
+  struct BusEvent {
+    byte topic;
+    byte event;   // DR_EV_PRESS, DR_EV_VALUE, ... or a user id from DR_EV_USER
+    byte handle;  // Publishing component, INVALID_HANDLE for device.publish()
+    int value;
+  };
+
+  typedef Delegate<void(const BusEvent&)> BusHandler;
+
+  // Subscribers are kept sorted by topic in parallel arrays, so publishing is
+  // a binary search on the topic bytes and then a contiguous run of handlers
+  class EventBus {
+    public:
+      void subscribe(byte topic, BusHandler handler) {
+        if (count >= TOTAL_SUBSCRIBERS) {
+          Serial.println("FATAL ERROR: Too many subscribers. Increase TOTAL_SUBSCRIBERS. Halting.");
+          while(1);
+        }
+        byte first = lowerBound(topic);
+        byte end = first;
+        while (end < count && topics[end] == topic) {
+          end++;
+        }
+        if (end - first >= MAX_SUBSCRIBERS_PER_TOPIC) {
+          Serial.println("FATAL ERROR: Too many subscribers on one topic. Increase MAX_SUBSCRIBERS_PER_TOPIC. Halting.");
+          while(1);
+        }
+        // Insert after the topic's existing subscribers to keep call order
+        for (byte i = count; i > end; i--) {
+          topics[i] = topics[i - 1];
+          handlers[i] = handlers[i - 1];
+        }
+        topics[end] = topic;
+        handlers[end] = handler;
+        count++;
+      }
+
+      void publish(byte topic, byte event, byte handle, int value) {
+        BusEvent e = { topic, event, handle, value };
+        byte i = lowerBound(topic);
+        // The per-topic bound caps the fan-out of a single publish
+        for (byte n = 0; n < MAX_SUBSCRIBERS_PER_TOPIC && i < count && topics[i] == topic; n++, i++) {
+          handlers[i](e);
+        }
+      }
+
+    private:
+      byte topics[TOTAL_SUBSCRIBERS];
+      BusHandler handlers[TOTAL_SUBSCRIBERS];
+      byte count = 0;
+
+      byte lowerBound(byte topic) {
+        byte low = 0;
+        byte high = count;
+        while (low < high) {
+          byte mid = (low + high) >> 1;
+          if (topics[mid] < topic) {
+            low = mid + 1;
+          } else {
+            high = mid;
+          }
+        }
+        return low;
+      }
+  };
+
+  // Used inside components that carry bus, topic and handle members
+  #define DR_PUBLISH(src, ev, value) do { \
+      if (topic != DR_NO_TOPIC && bus != nullptr) { \
+        DR_CALLBACK(src, bus->publish(topic, ev, handle, value)); \
+      } \
+    } while (0)
+#else
+  #define DR_PUBLISH(src, ev, value)
+#endif
+/****** END EVENT BUS *******************************************************/
+
+/****** LOOP MONITOR ********************************************************/
+// Usage: #define DEVICE_REACTOR_LOOP_MONITOR before including this library,
+// then device.onOverrun(limitUs, callback)
+#ifdef DEVICE_REACTOR_LOOP_MONITOR
+  // Histogram bucket i counts periods/durations in [i, i + 1) * DR_LOOP_BUCKET_US,
+  // the last bucket counts everything above
+  #ifndef DR_LOOP_BUCKETS
+    #define DR_LOOP_BUCKETS 8
+  #endif
+
+  #ifndef DR_LOOP_BUCKET_US
+    #define DR_LOOP_BUCKET_US 250
+  #endif
+
+  // One per device, so the period is the time between that device's own
+  // update() calls even when loop() updates several devices
+  struct LoopMonitor {
+    // Statistics (all times in microseconds)
+    unsigned long passes = 0;
+    unsigned long overruns = 0;
+    unsigned long maxPeriod = 0;
+    unsigned long maxDuration = 0;
+    uint16_t periodHistogram[DR_LOOP_BUCKETS] = {0};
+    uint16_t durationHistogram[DR_LOOP_BUCKETS] = {0};
+
+    // Overrun alarm
+    unsigned long limitUs = 0;
+    overrunCallback overrun = nullptr;
+
+    // What is running right now, updated by the section hooks
+    byte source = DR_SRC_SKETCH;
+    byte index = INVALID_HANDLE;
+
+    unsigned long passStart = 0;
+    bool overran = false;      // This pass has already been blamed
+    unsigned long blameElapsed = 0;
+    byte blameSource = DR_SRC_SKETCH;
+    byte blameIndex = INVALID_HANDLE;
+
+    static void record(uint16_t* histogram, unsigned long us) {
+      unsigned long bucket = us / DR_LOOP_BUCKET_US;
+      if (bucket >= DR_LOOP_BUCKETS) {
+        bucket = DR_LOOP_BUCKETS - 1;
+      }
+      if (histogram[bucket] < 0xFFFF) {  // Saturate rather than wrap
+        histogram[bucket]++;
+      }
+    }
+
+    void enter(byte src) {
+      source = src;
+      index = INVALID_HANDLE;
+    }
+
+    void item(byte i) {
+      check();
+      index = i;
+    }
+
+    // Blames whatever is running the first time the pass exceeds the limit
+    void check() {
+      if (!overran && limitUs > 0) {
+        unsigned long elapsed = micros() - passStart;
+        if (elapsed > limitUs) {
+          overran = true;
+          blameElapsed = elapsed;
+          blameSource = source;
+          blameIndex = index;
+        }
+      }
+    }
+
+    void beginPass() {
+      unsigned long now = micros();
+      if (passes > 0) {
+        // Note: (now - passStart) handles micros() rollover correctly
+        unsigned long period = now - passStart;
+        record(periodHistogram, period);
+        if (period > maxPeriod) {
+          maxPeriod = period;
+        }
+        // A slow pass was already blamed, anything else is the sketch's loop()
+        if (!overran && limitUs > 0 && period > limitUs) {
+          overruns++;
+          if (overrun != nullptr) {
+            overrun(period, DR_SRC_SKETCH, INVALID_HANDLE);
+          }
+        }
+      }
+      passes++;
+      passStart = now;
+      overran = false;
+      enter(DR_SRC_UPDATE);
+    }
+
+    void endPass() {
+      unsigned long duration = micros() - passStart;
+      record(durationHistogram, duration);
+      if (duration > maxDuration) {
+        maxDuration = duration;
+      }
+      enter(DR_SRC_UPDATE);
+      check();
+      if (overran) {
+        overruns++;
+        if (overrun != nullptr) {
+          overrun(blameElapsed, blameSource, blameIndex);
+        }
+      }
+    }
+  };
+
+  // The monitor of the device whose update() is running, which the section
+  // hooks report to. Outside update() it is an idle monitor with no limit.
+  inline LoopMonitor*& drLoopMonitor() {
+    static LoopMonitor idle;
+    static LoopMonitor* active = &idle;
+    return active;
+  }
+
+  #define DR_MONITOR_ENTER(src)    drLoopMonitor()->enter(src)
+  #define DR_MONITOR_ITEM(i)       drLoopMonitor()->item(i)
+  #define DR_MONITOR_LEAVE()       drLoopMonitor()->check()
+  #define DR_MONITOR_SAVE(name)    byte name = drLoopMonitor()->source
+  #define DR_MONITOR_SOURCE(src)   drLoopMonitor()->source = (src)
+#else
+  #define DR_MONITOR_ENTER(src)
+  #define DR_MONITOR_ITEM(i)
+  #define DR_MONITOR_LEAVE()
+  #define DR_MONITOR_SAVE(name)
+  #define DR_MONITOR_SOURCE(src)
+#endif
+/****** END LOOP MONITOR ****************************************************/
+
+/****** EVENT TRACE *********************************************************/
+// Usage: #define DEVICE_REACTOR_TRACE before including this library, then
+// device.traceDump(Serial) and decode with extras/trace/dr_trace_decode.py
+#define DR_EV_BEGIN    0   // A section or callback starts
+#define DR_EV_END      1   // A section or callback ends
+#define DR_EV_PRESS    2
+#define DR_EV_RELEASE  3
+#define DR_EV_CW       4
+#define DR_EV_CCW      5
+#define DR_EV_VALUE    6   // Analog sensor reported a new value
+#define DR_EV_ZONE     7   // Analog sensor entered a new zone
+#define DR_EV_FIRE     8   // Interval fired, value is its message
+#define DR_EV_SHOW     9   // Pixel strip pushed a frame, value is the pixel count
+#define DR_EV_TIME    10   // Carries bits 16..30 of a long gap in value
+#define DR_EV_USER   128   // First id free for device.trace()
+
+#ifdef DEVICE_REACTOR_TRACE
+  // Ring size in records (8 bytes each), must be a power of two
+  #ifndef DR_TRACE_RECORDS
+    #ifdef __AVR__
+      #define DR_TRACE_RECORDS 32
+    #else
+      #define DR_TRACE_RECORDS 256
+    #endif
+  #endif
+
+  #if (DR_TRACE_RECORDS & (DR_TRACE_RECORDS - 1)) != 0
+    #error "DR_TRACE_RECORDS must be a power of two"
+  #endif
+
+  struct TraceRecord {
+    uint16_t dt;      // Microseconds since the previous record
+    byte source;      // DR_SRC_* id
+    byte index;       // Component handle, INVALID_HANDLE if not applicable
+    byte event;       // DR_EV_* id
+    byte reserved;
+    int16_t value;
+  };
+
+  static_assert(sizeof(TraceRecord) == 8, "TraceRecord must pack into 8 bytes");
+
+  struct TraceBuffer {
+    TraceRecord records[DR_TRACE_RECORDS];
+    uint16_t head;                // Next slot to write
+    uint16_t count;
+    unsigned long overwritten;    // Oldest records lost to wrap-around
+    unsigned long lastTime;       // micros() of the newest record
+    unsigned long oldestTime;     // micros() of the oldest record still held
+
+    // What is running right now, updated by the section hooks
+    byte source;
+    byte index;
+
+    void write(byte src, byte event, int value) {
+      unsigned long now = micros();
+      unsigned long delta = (count == 0) ? 0 : now - lastTime;
+      if (count == 0) {
+        oldestTime = now;
+      }
+      lastTime = now;
+      if (delta > 0xFFFF) {
+        unsigned long high = delta >> 16;
+        push((uint16_t)delta, src, DR_EV_TIME, high > 0x7FFF ? 0x7FFF : (int16_t)high);
+        delta = 0;
+      }
+      push((uint16_t)delta, src, event, value);
+    }
+
+    void push(uint16_t dt, byte src, byte event, int16_t value) {
+      if (count == DR_TRACE_RECORDS) {
+        // Dropping the oldest record moves the start of the trace forward
+        overwritten++;
+        oldestTime += advance(records[(head + 1) & (DR_TRACE_RECORDS - 1)]);
+      } else {
+        count++;
+      }
+      TraceRecord& rec = records[head];
+      rec.dt = dt;
+      rec.source = src;
+      rec.index = index;
+      rec.event = event;
+      rec.reserved = 0;
+      rec.value = value;
+      head = (head + 1) & (DR_TRACE_RECORDS - 1);
+    }
+
+    static unsigned long advance(const TraceRecord& rec) {
+      unsigned long us = rec.dt;
+      if (rec.event == DR_EV_TIME) {
+        us += (unsigned long)rec.value << 16;
+      }
+      return us;
+    }
+
+    void enter(byte src) {
+      source = src;
+      index = INVALID_HANDLE;
+      write(src, DR_EV_BEGIN, 0);
+    }
+
+    void leave(byte src) {
+      write(src, DR_EV_END, 0);
+      source = (src == DR_SRC_UPDATE) ? DR_SRC_SKETCH : DR_SRC_UPDATE;
+    }
+
+    byte beginCall(byte src) {
+      byte caller = source;
+      source = src;
+      write(src, DR_EV_BEGIN, 0);
+      return caller;
+    }
+
+    void endCall(byte src, byte caller) {
+      write(src, DR_EV_END, 0);
+      source = caller;
+    }
+  };
+
+  // Shared by every component class
+  inline TraceBuffer& drTrace() {
+    static TraceBuffer trace;
+    return trace;
+  }
+
+  #define DR_TRACE_ENTER(src)            drTrace().enter(src)
+  #define DR_TRACE_ITEM(i)               drTrace().index = (i)
+  #define DR_TRACE_LEAVE(src)            drTrace().leave(src)
+  #define DR_TRACE_CALL_BEGIN(name, src) byte name = drTrace().beginCall(src)
+  #define DR_TRACE_CALL_END(name, src)   drTrace().endCall(src, name)
+  #define DR_TRACE_EVENT(event, value)   drTrace().write(drTrace().source, event, value)
+#else
+  #define DR_TRACE_ENTER(src)
+  #define DR_TRACE_ITEM(i)
+  #define DR_TRACE_LEAVE(src)
+  #define DR_TRACE_CALL_BEGIN(name, src)
+  #define DR_TRACE_CALL_END(name, src)
+  #define DR_TRACE_EVENT(event, value)
+#endif
+/****** END EVENT TRACE *****************************************************/
+
+/****** INPUT RECORDING *****************************************************/
+// Usage: #define DEVICE_REACTOR_RECORD before including this library, then
+// device.recordInputs(stream). Replay the capture with extras/host.
+//
+// Format: "DRR1", the board's A0 pin number (1 byte, so the replay can tell
+// analog pins apart), then one record per input change:
+//   varint milliseconds since the previous record, pin (1 byte), varint value
+// Varints are 7 bits per byte, least significant first, high bit = more.
+#ifdef DEVICE_REACTOR_RECORD
+  // Pins at or above this number are read normally but not recorded. Analog
+  // pins can be numbered past the digital ones (A6/A7 are 20/21 on a Nano).
+  #ifndef DR_RECORD_PINS
+    #if defined(NUM_DIGITAL_PINS) && defined(NUM_ANALOG_INPUTS)
+      #define DR_RECORD_PINS (A0 + NUM_ANALOG_INPUTS > NUM_DIGITAL_PINS ? A0 + NUM_ANALOG_INPUTS : NUM_DIGITAL_PINS)
+    #elif defined(NUM_DIGITAL_PINS)
+      #define DR_RECORD_PINS NUM_DIGITAL_PINS
+    #else
+      #define DR_RECORD_PINS 70
+    #endif
+  #endif
+
+  struct InputRecorder {
+    Stream* out;
+    unsigned long lastTime;
+    int16_t last[DR_RECORD_PINS];  // -1 = not seen since recording started
+
+    void start(Stream& stream) {
+      out = &stream;
+      lastTime = millis();
+      memset(last, 0xFF, sizeof(last));
+      out->write((const uint8_t*)"DRR1", 4);
+      out->write((uint8_t)A0);
+    }
+
+    void writeVarint(unsigned long value) {
+      while (value >= 0x80) {
+        out->write((uint8_t)(value | 0x80));
+        value >>= 7;
+      }
+      out->write((uint8_t)value);
+    }
+
+    void input(byte pin, int value) {
+      if (out == nullptr || pin >= DR_RECORD_PINS || last[pin] == value) {
+        return;
+      }
+      last[pin] = value;
+      unsigned long now = millis();
+      writeVarint(now - lastTime);
+      lastTime = now;
+      out->write(pin);
+      writeVarint((unsigned int)value);
+    }
+  };
+
+  // Shared by every component class
+  inline InputRecorder& drRecorder() {
+    static InputRecorder recorder;
+    return recorder;
+  }
+#endif
+
+// Every input the library samples goes through these so it can be recorded
+inline int drDigitalRead(byte pin) {
+  int value = digitalRead(pin);
+  #ifdef DEVICE_REACTOR_RECORD
+    drRecorder().input(pin, value);
+  #endif
+  return value;
+}
+
+inline int drAnalogRead(byte pin) {
+  int value = analogRead(pin);
+  #ifdef DEVICE_REACTOR_RECORD
+    drRecorder().input(pin, value);
+  #endif
+  return value;
+}
+/****** END INPUT RECORDING *************************************************/
+
+/****** SECTION HOOKS *******************************************************/
+// Mark the parts of Device::update() and the user callbacks for the profiler,
+// the loop monitor and the event trace; they expand to nothing when all three
+// are disabled
+#define DR_SECTION_BEGIN(name, src) DR_PROFILE_BEGIN(name); DR_MONITOR_ENTER(src); DR_TRACE_ENTER(src)
+#define DR_SECTION_ITEM(i)          DR_MONITOR_ITEM(i); DR_TRACE_ITEM(i)
+#define DR_SECTION_END(name, src)   DR_TRACE_LEAVE(src); DR_MONITOR_LEAVE(); DR_PROFILE_END(name, src)
+#define DR_CALLBACK(src, call) do { \
+    DR_PROFILE_BEGIN(drCallStart); \
+    DR_MONITOR_SAVE(drCaller); \
+    DR_MONITOR_SOURCE(src); \
+    DR_TRACE_CALL_BEGIN(drTraceCaller, src); \
+    call; \
+    DR_TRACE_CALL_END(drTraceCaller, src); \
+    DR_MONITOR_LEAVE(); \
+    DR_MONITOR_SOURCE(drCaller); \
+    DR_PROFILE_END(drCallStart, src); \
+  } while (0)
+
+#if defined(DEVICE_REACTOR_PROFILE) || defined(DEVICE_REACTOR_LOOP_MONITOR)
+  inline void drPrintSource(Print& out, byte src) {
+    switch (src) {
+      case DR_SRC_UPDATE:      out.print(F("update"));       break;
+      case DR_SRC_LEDS:        out.print(F("leds"));         break;
+      case DR_SRC_LED_GROUPS:  out.print(F("ledGroups"));    break;
+      case DR_SRC_BUTTONS:     out.print(F("buttons"));      break;
+      case DR_SRC_ENCODERS:    out.print(F("encoders"));     break;
+      case DR_SRC_ANALOG:      out.print(F("analog"));       break;
+      case DR_SRC_INTERVALS:   out.print(F("intervals"));    break;
+      case DR_SRC_PIXELS:      out.print(F("pixelStrips"));  break;
+      case DR_SRC_SHIFT:       out.print(F("shift"));        break;
+      case DR_SRC_CHARLIE:     out.print(F("charlie"));      break;
+      case DR_SRC_FAST_OUTPUT: out.print(F("fastOutput"));   break;
+      case DR_SRC_BUTTON_CB:   out.print(F("buttonCb"));     break;
+      case DR_SRC_ENCODER_CB:  out.print(F("encoderCb"));    break;
+      case DR_SRC_ANALOG_CB:   out.print(F("analogCb"));     break;
+      case DR_SRC_INTERVAL_CB: out.print(F("intervalCb"));   break;
+      case DR_SRC_PIXEL_CB:    out.print(F("pixelCb"));      break;
+      case DR_SRC_SKETCH:      out.print(F("sketch"));       break;
+      case DR_SRC_LED_CB:      out.print(F("ledCb"));        break;
+      case DR_SRC_SEQUENCERS:  out.print(F("sequencers"));   break;
+      case DR_SRC_SEQUENCE_CB: out.print(F("sequenceCb"));   break;
+    }
+  }
+#endif
+/****** END SECTION HOOKS ***************************************************/
+
+// Scale an 8-bit value by an 8-bit factor without division (255 = unchanged)
+inline byte drScale8(byte value, byte factor) {
+  return ((unsigned int)value * (factor + 1)) >> 8;
+}
+
+/****** BUTTON MODES *********************************************************/
+#define BUTTON_PRESS_HIGH 0
+#define BUTTON_PRESS_LOW 1
+#define BUTTON_INPUT_PULLUP 2
+
+/****** PIXEL STRIP TRANSPORTS ***********************************************/
+#define PIXEL_WS2812 0   // Single-wire, bit-banged (AVR @ 16MHz)
+#define PIXEL_APA102 1   // Data + clock, hardware SPI or shiftOut()
+#define PIXEL_CAPTURE 2  // No hardware, frames are handed to onFrame()
+
+/****** TYPED HANDLES ********************************************************/
+// Returned by device.newLED() etc. They convert to byte, so existing sketches
+// keep working, but passing one to another component's accessor won't compile
+class LED;
+class Button;
+class AnalogSensor;
+class RotaryEncoder;
+class RadioGroup;
+class Sequencer;
+class HysteresisController;
+
+template <typename Component>
+class ComponentHandle {
+  public:
+    constexpr ComponentHandle() : value(INVALID_HANDLE) {}
+    constexpr explicit ComponentHandle(byte index) : value(index) {}
+    constexpr operator byte() const { return value; }
+
+  private:
+    byte value;
+};
+
+typedef ComponentHandle<LED> LedHandle;
+typedef ComponentHandle<Button> ButtonHandle;
+typedef ComponentHandle<AnalogSensor> AnalogSensorHandle;
+typedef ComponentHandle<RotaryEncoder> RotaryEncoderHandle;
+typedef ComponentHandle<RadioGroup> RadioGroupHandle;
+typedef ComponentHandle<Sequencer> SequencerHandle;
+typedef ComponentHandle<HysteresisController> HysteresisControllerHandle;
+
+/*****************************************************************************
+ * INTERVAL CLASS
+ *****************************************************************************/
+  template <class Cfg> class DeviceT;  // Forward declaration
+
+  // Owner is the device type that created the interval; it forwards to its
+  // interval pool. A default-constructed handle refers to no interval.
+  template <class Owner>
+  class BasicIntervalHandle {
+    public:
+      BasicIntervalHandle() : device(nullptr), index(INVALID_HANDLE) {}
+      BasicIntervalHandle(Owner* dev, byte idx) : device(dev), index(idx) {}
+
+      BasicIntervalHandle& withMessage(byte msg) {
+        if (device) device->_setIntervalMessage(index, msg);
+        return *this;
+      }
+      void stop() {
+        if (device) device->_clearInterval(index);
+      }
+      void pause() {
+        if (device) device->_pauseInterval(index);
+      }
+      void resume() {
+        if (device) device->_resumeInterval(index);
+      }
+
+    private:
+      Owner* device;
+      byte index;
+  };
+
+  template <byte Slots>
+  class IntervalSlots {
+    public:
+      IntervalSlots() {
+        // Initialize all slots to inactive and unpaused
+        for (byte i = 0; i < Slots; i++) {
+          counts[i] = -1;
+          paused[i] = false;
+        }
+      }
+
+      byte add(const CallbackSlot<byte>& callback, unsigned long wait, int count, byte msg) {
+        // Find an available slot for reuse
+        byte slot = findSlot();
+
+        if (slot >= Slots) {
+          Serial.println("FATAL ERROR: All interval slots used. Increase TOTAL_INTERVALS or Intervals<N>. Halting.");
+          while(1);
+        }
+
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("New interval on slot ");
+          DR_DEBUG_PRINT(slot);
+          DR_DEBUG_PRINT(" with msg=");
+          DR_DEBUG_PRINTLN(msg);
+        #endif
+
+        // Fully initialize the slot to prevent stale data issues
+        callbacks[slot] = callback;
+        waits[slot] = wait;
+        counts[slot] = count;
+        msgs[slot] = msg;
+        lastRuns[slot] = millis();
+        paused[slot] = false;  // Ensure slot is not paused
+        setRunning(slot, true);
+        return slot;
+      }
+
+      void clear(byte index) {
+        if (index < Slots) {
+          // Mark as inactive (stops it from running and makes slot available for reuse)
+          // Note: We clear the callback pointer first to prevent race conditions if
+          // clear() is called from within a callback during update() iteration
+          callbacks[index].clear();  // Clear callback to prevent stale function pointers
+          setRunning(index, false);
+          counts[index] = -1;
+          paused[index] = false;  // Reset paused state for slot reuse
+          waits[index] = 0;
+          msgs[index] = 0;
+          lastRuns[index] = 0;
+        }
+      }
+
+      void setMessage(byte index, byte msg) {
+        // Bounds check and verify slot is active
+        if (index >= Slots) {
+          #ifdef DEVICE_REACTOR_DEBUG
+            DR_DEBUG_PRINT("ERROR: Invalid interval index ");
+            DR_DEBUG_PRINTLN(index);
+          #endif
+          return;
+        }
+        if (counts[index] >= 0) {
+          msgs[index] = msg;
+        }
+      }
+
+      void pause(byte index) {
+        // Bounds check and verify slot is active
+        if (index >= Slots) {
+          #ifdef DEVICE_REACTOR_DEBUG
+            DR_DEBUG_PRINT("ERROR: Invalid interval index ");
+            DR_DEBUG_PRINTLN(index);
+          #endif
+          return;
+        }
+        if (counts[index] >= 0) {
+          paused[index] = true;
+          setRunning(index, false);
+          #ifdef DEVICE_REACTOR_DEBUG
+            DR_DEBUG_PRINT("Interval ");
+            DR_DEBUG_PRINT(index);
+            DR_DEBUG_PRINTLN(" paused");
+          #endif
+        }
+      }
+
+      void resume(byte index) {
+        // Bounds check and verify slot is active
+        if (index >= Slots) {
+          #ifdef DEVICE_REACTOR_DEBUG
+            DR_DEBUG_PRINT("ERROR: Invalid interval index ");
+            DR_DEBUG_PRINTLN(index);
+          #endif
+          return;
+        }
+        if (counts[index] >= 0) {
+          paused[index] = false;
+          setRunning(index, true);
+          // Reset the timer to prevent immediate firing after resume
+          lastRuns[index] = millis();
+          #ifdef DEVICE_REACTOR_DEBUG
+            DR_DEBUG_PRINT("Interval ");
+            DR_DEBUG_PRINT(index);
+            DR_DEBUG_PRINTLN(" resumed");
+          #endif
+        }
+      }
+
+      void update() {
+        for (byte i = 0; i < Slots; i++) {
+          // Free and paused slots cost a single bit test
+          if (!(running[i >> 3] & (1 << (i & 7)))) {
+            continue;
+          }
+          DR_SECTION_ITEM(i);
+          // Only process active intervals (-1 is inactive) and skip paused intervals
+          // Check callback is not null to prevent race conditions with clear()
+          if (counts[i] >= 0 && !paused[i] && callbacks[i].isSet()) {
+            // Check if the time since the last run is >= the wait
+            // Note: (millis() - lastRuns[i]) handles millis() rollover correctly
+            if ((millis() - lastRuns[i]) >= waits[i]) {
+              // Store callback locally in case clear() is called during execution
+              CallbackSlot<byte> localCallback = callbacks[i];
+              byte localMsg = msgs[i];
+
+              // Decrement count AFTER callback to prevent double execution
+              DR_TRACE_EVENT(DR_EV_FIRE, localMsg);
+              DR_CALLBACK(DR_SRC_INTERVAL_CB, localCallback(i, localMsg)); // Run the callback function
+              lastRuns[i] = millis(); // Update the last run
+
+              // Now update count state after callback (check callback still valid)
+              if (counts[i] > 0 && callbacks[i].isSet()) {
+                counts[i]--; // Decrement the count
+                // Check if the count has reached 0
+                if (counts[i] == 0) {
+                  counts[i] = -1; // Mark as inactive after final execution
+                  setRunning(i, false);
+                }
+              }
+            }
+          }
+        }
+      }
+
+      #ifdef DEVICE_REACTOR_DEBUG
+        void printStatus() {
+          DR_DEBUG_PRINTLN("INTERVAL DEBUG:");
+          for (byte i = 0; i < Slots; i++) {
+            if (counts[i] >= 0) {
+              DR_DEBUG_PRINT("(");
+              DR_DEBUG_PRINT(i);
+              DR_DEBUG_PRINT(") Count:");
+              DR_DEBUG_PRINT(counts[i]);
+              DR_DEBUG_PRINT(" Wait:");
+              DR_DEBUG_PRINT(waits[i]);
+              DR_DEBUG_PRINT(" Msg:");
+              DR_DEBUG_PRINTLN(msgs[i]);
+            }
+          }
+          DR_DEBUG_PRINTLN("-------------------------");
+        }
+      #endif
+
+    private:
+      CallbackSlot<byte> callbacks[Slots];
+      int counts[Slots];  // -1 = inactive, 0 = infinite, >0 = remaining
+      unsigned long waits[Slots];
+      unsigned long lastRuns[Slots];
+      byte msgs[Slots];
+      bool paused[Slots];
+      byte running[(Slots + 7) / 8] = {0};  // Bit set = active and not paused
+
+      void setRunning(byte index, bool on) {
+        if (on) {
+          running[index >> 3] |= (1 << (index & 7));
+        } else {
+          running[index >> 3] &= ~(1 << (index & 7));
+        }
+      }
+
+      // Find an empty interval slot
+      byte findSlot() {
+        for (byte i = 0; i < Slots; i++) {
+          if (counts[i] == -1) {
+            return i;
+          }
+        }
+        // No empty slot found
+        return INVALID_HANDLE;
+      }
+  };
+
+#if TOTAL_INTERVALS > 0
+  typedef IntervalSlots<TOTAL_INTERVALS> Interval;
+#endif
+
+/*****************************************************************************
+ * ANALOG SENSOR CLASS
+ *****************************************************************************/
+  class AnalogSensor {
+    public:
+      // Sprint 5: Preset enum for common configurations
+      enum Preset {
+        RAW_DATA,              // No processing, raw 0-1023 values
+        POT_FOR_LED,           // Smooth, continuous 0-255 for analogWrite
+        POT_FOR_SERVO,         // Smooth, continuous 0-180 for servo control
+        POT_FOR_PERCENTAGE,    // Stable 0-100 in steps of 5
+        SWITCH_5_POSITION      // Heavy 5-position switch (0-4)
+      };
+
+      // Sprint 5: Preset configuration structure
+      struct PresetConfig {
+        byte smoothing_samples;
+        int output_min;
+        int output_max;
+        int quantize_step;      // Q value
+        int hysteresis_amount;  // H value
+        int change_threshold;   // T value for non-quantized mode
+      };
+
+      // Zone structure for zone-based state management
+      struct Zone {
+        byte id;
+        int min_val;
+        int max_val;
+      };
+
+      // Sprint 5: Preset configuration data, one entry per preset.
+      // The order MUST EXACTLY MATCH the order of the Preset enum.
+      static const PresetConfig& presetConfig(byte index) {
+        static const PresetConfig configs[] = {
+          // RAW_DATA: No processing, raw 0-1023 values
+          { /*smoothing*/ 1, /*out_min*/ 0, /*out_max*/ 1023, /*Q*/ 0, /*H*/ 0, /*T*/ 1 },
+
+          // POT_FOR_LED: Smooth, continuous 0-255 for analogWrite
+          { /*smoothing*/ 8, /*out_min*/ 0, /*out_max*/ 255,  /*Q*/ 0, /*H*/ 0, /*T*/ 2 },
+
+          // POT_FOR_SERVO: Smooth, continuous 0-180 for servo control
+          { /*smoothing*/ 8, /*out_min*/ 0, /*out_max*/ 180,  /*Q*/ 0, /*H*/ 0, /*T*/ 2 },
+
+          // POT_FOR_PERCENTAGE: Stable 0-100 in steps of 5 (T is irrelevant, Q > 0)
+          { /*smoothing*/ 10, /*out_min*/ 0, /*out_max*/ 100, /*Q*/ 5, /*H*/ 1, /*T*/ 1 },
+
+          // SWITCH_5_POSITION: Heavy 5-position switch with strong hysteresis
+          { /*smoothing*/ 12, /*out_min*/ 0, /*out_max*/ 4,   /*Q*/ 1, /*H*/ 1, /*T*/ 1 }
+        };
+        return configs[index];
+      }
+
+      byte pin;
+      byte handle = INVALID_HANDLE;  // Set by the device, passed to context callbacks
+      unsigned long* dueAt = nullptr;  // Owner's next sensor pass, set by the device
+      #if TOTAL_SUBSCRIBERS > 0
+        EventBus* bus = nullptr;       // Set by the device
+        byte topic = DR_NO_TOPIC;      // Bus topic for this component's events
+      #endif
+
+      void init(byte newPin) {
+        if (initialized) {
+          Serial.println("WARNING: AnalogSensor already initialized. Ignoring.");
+          return;
+        }
+        pin = newPin;
+        initialized = true;
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("Setup Analog Sensor on pin ");
+          DR_DEBUG_PRINTLN(pin);
+        #endif
+      }
+
+      AnalogSensor& inputRange(int newMin, int newMax) {
+        inputMin = newMin;
+        inputMax = newMax;
+        return *this;
+      }
+
+      AnalogSensor& outputRange(int newMin, int newMax) {
+        outputMin = newMin;
+        outputMax = newMax;
+        return *this;
       }
 
       AnalogSensor& invert() {
@@ -336,1189 +1485,4007 @@ typedef void (*intParamCallback)(int);
         return *this;
       }
 
-      // Sprint 5: Overloaded quantize() methods
-      AnalogSensor& quantize(int step) {
-        quantizeStep = step;
-        // Automatically calculate H = Q / 4 for balanced feel
-        hysteresis_amount = step / 4;
+      // Sprint 5: Overloaded quantize() methods
+      AnalogSensor& quantize(int step) {
+        quantizeStep = step;
+        // Automatically calculate H = Q / 4 for balanced feel
+        hysteresis_amount = step / 4;
+        return *this;
+      }
+
+      AnalogSensor& quantize(int step, int hysteresis) {
+        quantizeStep = step;
+        hysteresis_amount = hysteresis;
+        return *this;
+      }
+
+      AnalogSensor& changeThreshold(int threshold) {
+        delta = threshold;
+        return *this;
+      }
+
+      AnalogSensor& smoothing(byte samples) {
+        avgSamples = samples < 1 ? 1 : samples;
+        return *this;
+      }
+
+      // Read the ADC at most once every ms (0 = every update). Between samples
+      // the sensor is skipped entirely by Device::update().
+      AnalogSensor& sampleInterval(unsigned long ms) {
+        sampleEvery = ms;
+        if (dueAt != nullptr) {
+          *dueAt = millis();  // Have the owner re-plan its sensor pass
+        }
+        return *this;
+      }
+
+      bool sampleDue(unsigned long now) {
+        // Note: (now - lastSampleTime) handles millis() rollover correctly
+        return (now - lastSampleTime) >= sampleEvery;
+      }
+
+      unsigned long timeUntilDue(unsigned long now) {
+        unsigned long elapsed = now - lastSampleTime;
+        return (elapsed >= sampleEvery) ? 0 : sampleEvery - elapsed;
+      }
+
+      AnalogSensor& onChange(Delegate<void(int)> callback) {
+        changed.set(callback);
+        return *this;
+      }
+
+      AnalogSensor& onChange(contextIntCallback callback, void* ctx) {
+        changed.set(callback, ctx);
+        return *this;
+      }
+
+      #if TOTAL_SUBSCRIBERS > 0
+        // Also publish value and zone changes on the device's event bus
+        AnalogSensor& publishTo(byte busTopic) {
+          topic = busTopic;
+          return *this;
+        }
+      #endif
+
+      // Sprint 2: Zone configuration methods
+      AnalogSensor& addZone(byte id, int min_value, int max_value) {
+        if (zone_count >= MAX_ZONES_PER_SENSOR) {
+          #ifdef DEVICE_REACTOR_DEBUG
+            DR_DEBUG_PRINTLN("ERROR: Maximum zones reached for this sensor");
+          #endif
+          return *this;
+        }
+
+        // Validate zone boundaries
+        if (min_value > max_value) {
+          #ifdef DEVICE_REACTOR_DEBUG
+            DR_DEBUG_PRINTLN("ERROR: Zone min_value must be <= max_value");
+          #endif
+          return *this;
+        }
+
+        defined_zones[zone_count].id = id;
+        defined_zones[zone_count].min_val = min_value;
+        defined_zones[zone_count].max_val = max_value;
+        zone_count++;
+
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("Defined zone ID ");
+          DR_DEBUG_PRINT(id);
+          DR_DEBUG_PRINT(" [");
+          DR_DEBUG_PRINT(min_value);
+          DR_DEBUG_PRINT(", ");
+          DR_DEBUG_PRINT(max_value);
+          DR_DEBUG_PRINTLN("]");
+        #endif
+
+        return *this;
+      }
+
+      AnalogSensor& clearZones() {
+        zone_count = 0;
+        currentZoneID = INVALID_HANDLE;
+        previousZoneID = INVALID_HANDLE;
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINTLN("Cleared all zones");
+        #endif
+        return *this;
+      }
+
+      // Sprint 5: High-level preset configuration
+      AnalogSensor& configure(Preset preset) {
+        // Cast enum to index for array lookup
+        int index = static_cast<int>(preset);
+        const PresetConfig& config = presetConfig(index);
+
+        // Apply common settings
+        smoothing(config.smoothing_samples);
+        outputRange(config.output_min, config.output_max);
+
+        // Apply stability mode based on recipe
+        if (config.quantize_step > 0) {
+          // Quantization mode enabled
+          // If H is 0 in table, use auto-calculated default (Q/4)
+          int h = (config.hysteresis_amount > 0)
+                    ? config.hysteresis_amount
+                    : config.quantize_step / 4;
+          quantize(config.quantize_step, h);
+        } else {
+          // Continuous mode with change threshold
+          changeThreshold(config.change_threshold);
+        }
+
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("Applied preset configuration: ");
+          DR_DEBUG_PRINTLN(index);
+        #endif
+
+        return *this;
+      }
+
+      // Sprint 4: Zone change event callback
+      AnalogSensor& onZoneChange(Delegate<void(byte)> callback) {
+        zoneChanged.set(callback);
+        return *this;
+      }
+
+      AnalogSensor& onZoneChange(contextByteCallback callback, void* ctx) {
+        zoneChanged.set(callback, ctx);
+        return *this;
+      }
+
+      int value() {
+        // Perform initial read on first call with configured settings
+        if (!hasInitialRead) {
+          performInitialRead();
+        }
+        return currentValue;
+      }
+
+      void update() {
+        lastSampleTime = millis();
+
+        // Perform initial read if not done yet (in case update() called before value())
+        if (!hasInitialRead) {
+          performInitialRead();
+          return;  // Don't fire onChange on initial read
+        }
+
+        // Read raw ADC value
+        int rawValue = drAnalogRead(pin);
+
+        // Apply smoothing
+        if (avgSamples > 1) {
+          average(rawValue);
+        } else {
+          accumulatedSum = rawValue;
+          avgCount = 1;  // Single sample, ready to process
+        }
+
+        // Only process when averaging is complete (avgCount == avgSamples)
+        if (avgCount >= avgSamples) {
+          // Calculate the average value from accumulated sum
+          int avgValue = accumulatedSum / avgSamples;
+
+          // Clamp to INPUT range first
+          if (avgValue < inputMin) avgValue = inputMin;
+          if (avgValue > inputMax) avgValue = inputMax;
+
+          // Map from input range to output range
+          hiResValue = map(avgValue, inputMin, inputMax, outputMin, outputMax);
+
+          // Clamp to OUTPUT range
+          if (hiResValue < outputMin) hiResValue = outputMin;
+          if (hiResValue > outputMax) hiResValue = outputMax;
+
+          // Apply inversion if enabled
+          if (inverted) {
+            hiResValue = outputMax + outputMin - hiResValue;
+          }
+
+          // Sprint 3: Mode selection logic for stability
+          bool valueChanged = false;
+          int newValue = hiResValue;
+
+          if (quantizeStep > 0) {
+            // Mode 1: Quantized Hysteresis (Q+H)
+            // Calculate the potential quantized value using proper rounding
+            int V_potential = round((float)hiResValue / quantizeStep) * quantizeStep;
+
+            // Clamp V_potential to output range
+            if (V_potential < outputMin) V_potential = outputMin;
+            if (V_potential > outputMax) V_potential = outputMax;
+
+            // Check if we've crossed a quantization boundary
+            if (V_potential != currentReportedValue) {
+              if (V_potential > currentReportedValue) {
+                // Value is increasing - check upper trigger
+                int trigger_up = (currentReportedValue + quantizeStep / 2) + hysteresis_amount;
+                if (hiResValue >= trigger_up) {
+                  newValue = V_potential;
+                  valueChanged = true;
+                }
+              } else {
+                // Value is decreasing - check lower trigger
+                int trigger_down = (currentReportedValue - quantizeStep / 2) - hysteresis_amount;
+                if (hiResValue <= trigger_down) {
+                  newValue = V_potential;
+                  valueChanged = true;
+                }
+              }
+            }
+          } else if (delta > 1) {
+            // Mode 2: Change Threshold (Floating Anchor)
+            if (abs(hiResValue - currentReportedValue) >= delta) {
+              newValue = hiResValue;
+              valueChanged = true;
+            }
+          } else {
+            // Mode 3: Raw Mode (delta == 1, no quantization)
+            if (hiResValue != currentReportedValue) {
+              newValue = hiResValue;
+              valueChanged = true;
+            }
+          }
+
+          // Update state and fire onChange if value changed
+          if (valueChanged) {
+            currentReportedValue = newValue;
+            currentValue = newValue;  // Keep currentValue in sync for backward compatibility
+            previousValue = newValue; // Keep previousValue in sync
+
+            #ifdef DEVICE_REACTOR_DEBUG
+              DR_DEBUG_PRINT("Analog sensor value changed to ");
+              DR_DEBUG_PRINTLN(currentReportedValue);
+            #endif
+
+            DR_TRACE_EVENT(DR_EV_VALUE, currentReportedValue);
+            if (changed.isSet()) {
+              DR_CALLBACK(DR_SRC_ANALOG_CB, changed(handle, currentReportedValue));
+            }
+            DR_PUBLISH(DR_SRC_ANALOG_CB, DR_EV_VALUE, currentReportedValue);
+          }
+
+          // Sprint 4: Zone detection and event firing
+          if (zone_count > 0) {
+            // Find which zone the currentReportedValue falls into
+            byte detectedZoneID = findZoneForValue(currentReportedValue);
+
+            // Update currentZoneID
+            currentZoneID = detectedZoneID;
+
+            // Fire onZoneChange if zone changed
+            if (currentZoneID != previousZoneID) {
+              previousZoneID = currentZoneID;
+
+              #ifdef DEVICE_REACTOR_DEBUG
+                DR_DEBUG_PRINT("Zone changed to ");
+                DR_DEBUG_PRINTLN(currentZoneID);
+              #endif
+
+              DR_TRACE_EVENT(DR_EV_ZONE, currentZoneID);
+              if (zoneChanged.isSet()) {
+                DR_CALLBACK(DR_SRC_ANALOG_CB, zoneChanged(handle, currentZoneID));
+              }
+              DR_PUBLISH(DR_SRC_ANALOG_CB, DR_EV_ZONE, currentZoneID);
+            }
+          }
+
+          // Reset accumulator and counter for next cycle
+          accumulatedSum = 0;
+          avgCount = 0;
+        }
+      }
+
+    private:
+      bool initialized = false;
+      bool hasInitialRead = false;
+
+      // Input range (raw ADC values)
+      int inputMin = 0;
+      int inputMax = 1023;
+
+      // Output range (mapped values)
+      int outputMin = 0;
+      int outputMax = 1023;
+      bool inverted = false;
+      int quantizeStep = 0;  // 0 = disabled, >0 = snap to grid
+
+      // Change detection
+      int delta = 1;
+      int currentValue = 0;
+      int previousValue = 0;
+
+      // Sampling rate
+      unsigned long sampleEvery = 0;
+      unsigned long lastSampleTime = 0;
+
+      // Smoothing
+      byte avgSamples = 1;
+      byte avgCount = 0;
+      unsigned long accumulatedSum = 0;  // Use unsigned long to prevent overflow
+
+      // Callback
+      CallbackSlot<int> changed;
+
+      // Sprint 1: New state variables for Quantized Hysteresis and Zones
+      int hiResValue = 0;              // Value after smoothing, clamping, and mapping
+      int currentReportedValue = 0;    // Final stable value exposed to the user
+      int hysteresis_amount = 0;        // The 'H' value for Quantized Hysteresis
+
+      // Zone management
+      Zone defined_zones[MAX_ZONES_PER_SENSOR];
+      byte zone_count = 0;
+      byte currentZoneID = INVALID_HANDLE;
+      byte previousZoneID = INVALID_HANDLE;
+
+      // Sprint 4: Zone change callback
+      CallbackSlot<byte> zoneChanged;
+
+      template <class Cfg> friend class DeviceT;  // Bindings read the reported value and output range
+      friend class HysteresisController;
+
+      void average(int newReading) {
+        accumulatedSum += newReading;
+        avgCount++;
+        // avgCount will be checked in update() to determine if ready to process
+      }
+
+      // Sprint 2: Helper method to find zone for a given value
+      byte findZoneForValue(int val) {
+        #if MAX_ZONES_PER_SENSOR > 0
+          for (byte i = 0; i < zone_count; i++) {
+            if (val >= defined_zones[i].min_val && val <= defined_zones[i].max_val) {
+              return defined_zones[i].id;
+            }
+          }
+        #else
+          (void)val;  // No zone storage when MAX_ZONES_PER_SENSOR is 0
+        #endif
+        return INVALID_HANDLE;  // No zone found
+      }
+
+      void performInitialRead() {
+        // Read raw ADC value with all configured settings applied
+        int rawValue = drAnalogRead(pin);
+
+        // Pre-fill smoothing buffer with first reading for consistent behavior
+        if (avgSamples > 1) {
+          accumulatedSum = (unsigned long)rawValue * avgSamples;
+          avgCount = avgSamples;
+        } else {
+          accumulatedSum = rawValue;
+          avgCount = 1;
+        }
+
+        // Calculate average (same as update logic)
+        int avgValue = accumulatedSum / avgSamples;
+
+        // Clamp to INPUT range
+        if (avgValue < inputMin) avgValue = inputMin;
+        if (avgValue > inputMax) avgValue = inputMax;
+
+        // Map from input range to output range
+        hiResValue = map(avgValue, inputMin, inputMax, outputMin, outputMax);
+
+        // Clamp to OUTPUT range
+        if (hiResValue < outputMin) hiResValue = outputMin;
+        if (hiResValue > outputMax) hiResValue = outputMax;
+
+        // Apply inversion if enabled
+        if (inverted) {
+          hiResValue = outputMax + outputMin - hiResValue;
+        }
+
+        // Sprint 3: Initialize currentReportedValue based on mode
+        if (quantizeStep > 0) {
+          // Quantize to nearest grid point using proper rounding
+          currentReportedValue = round((float)hiResValue / quantizeStep) * quantizeStep;
+          // Clamp to output range
+          if (currentReportedValue < outputMin) currentReportedValue = outputMin;
+          if (currentReportedValue > outputMax) currentReportedValue = outputMax;
+        } else {
+          // For Change Threshold or Raw mode, use hiResValue directly
+          currentReportedValue = hiResValue;
+        }
+
+        // Keep legacy variables in sync for backward compatibility
+        currentValue = currentReportedValue;
+        previousValue = currentReportedValue;
+
+        // Initialize zone state to prevent onZoneChange firing on first update
+        if (zone_count > 0) {
+          byte initialZone = findZoneForValue(currentReportedValue);
+          currentZoneID = initialZone;
+          previousZoneID = initialZone;
+        }
+
+        // Reset accumulator for next update cycle
+        accumulatedSum = 0;
+        avgCount = 0;
+
+        hasInitialRead = true;
+
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("Initial analog sensor value: ");
+          DR_DEBUG_PRINTLN(currentReportedValue);
+        #endif
+      }
+  };
+
+/*****************************************************************************
+ * BUTTON CLASS
+ *****************************************************************************/
+  class Button {
+    public:
+      byte pin;
+      byte pressMode = BUTTON_INPUT_PULLUP;
+      byte handle = INVALID_HANDLE;  // Set by the device, passed to context callbacks
+      #if TOTAL_SUBSCRIBERS > 0
+        EventBus* bus = nullptr;       // Set by the device
+        byte topic = DR_NO_TOPIC;      // Bus topic for this component's events
+      #endif
+
+      void init(byte newPin, byte newMode = BUTTON_INPUT_PULLUP) {
+        if (initialized) {
+          Serial.println("WARNING: Button already initialized. Ignoring.");
+          return;
+        }
+        pin = newPin;
+        pressMode = newMode;
+
+        if (pressMode == BUTTON_INPUT_PULLUP) {
+          pinMode(pin, INPUT_PULLUP);
+        } else {
+          pinMode(pin, INPUT);
+        }
+
+        // Read the actual pin state to avoid missing first state change
+        state = drDigitalRead(pin);
+        oldState = state;
+        initialized = true;
+
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("Setup button on pin ");
+          DR_DEBUG_PRINT(pin);
+          DR_DEBUG_PRINT(" initial state: ");
+          DR_DEBUG_PRINTLN(state);
+        #endif
+      }
+
+      Button& onPress(Delegate<void()> callback) {
+        pressed.set(callback);
+        return *this;
+      }
+
+      Button& onPress(contextCallback callback, void* ctx) {
+        pressed.set(callback, ctx);
+        return *this;
+      }
+
+      Button& onRelease(Delegate<void()> callback) {
+        released.set(callback);
+        return *this;
+      }
+
+      Button& onRelease(contextCallback callback, void* ctx) {
+        released.set(callback, ctx);
+        return *this;
+      }
+
+      #if TOTAL_SUBSCRIBERS > 0
+        // Also publish presses and releases on the device's event bus
+        Button& publishTo(byte busTopic) {
+          topic = busTopic;
+          return *this;
+        }
+      #endif
+
+      void update() {
+        checkForPress();
+      }
+
+      // Debounced state, as last reported to onPress/onRelease
+      bool isPressed() {
+        return (pressMode == BUTTON_PRESS_HIGH) ? (oldState == HIGH) : (oldState == LOW);
+      }
+
+    protected:
+      bool initialized = false;
+      byte state = HIGH;
+      byte oldState = HIGH;
+      CallbackSlot<> pressed;
+      CallbackSlot<> released;
+      unsigned long lastDebounceTime = 0;
+
+      void checkForPress() {
+        // Get state
+        state = drDigitalRead(pin);
+
+        if (state != oldState) {
+          // Note: (millis() - lastDebounceTime) handles millis() rollover correctly
+          if ((millis() - lastDebounceTime) >= DEBOUNCE_DELAY) {
+            oldState = state;
+            lastDebounceTime = millis();
+
+            #ifdef DEVICE_REACTOR_DEBUG
+              DR_DEBUG_PRINT("Button state changed to ");
+              DR_DEBUG_PRINTLN(state);
+            #endif
+
+            bool nowPressed = isPressed();
+
+            DR_TRACE_EVENT(nowPressed ? DR_EV_PRESS : DR_EV_RELEASE, 0);
+            if (nowPressed && pressed.isSet()) {
+              DR_CALLBACK(DR_SRC_BUTTON_CB, pressed(handle));
+            } else if (!nowPressed && released.isSet()) {
+              DR_CALLBACK(DR_SRC_BUTTON_CB, released(handle));
+            }
+            DR_PUBLISH(DR_SRC_BUTTON_CB, nowPressed ? DR_EV_PRESS : DR_EV_RELEASE, 0);
+          } else {
+            #ifdef DEVICE_REACTOR_DEBUG
+              DR_DEBUG_PRINTLN("BUTTON DEBOUNCE PROTECTION");
+            #endif
+          }
+        }
+      }
+  };
+
+/*****************************************************************************
+ * ROTARY ENCODER CLASS
+ *****************************************************************************/
+  class RotaryEncoder : public Button {
+    public:
+      byte DT, CLK;
+
+      void init(byte swPin, byte dtPin, byte clkPin) {
+        if (initialized) {
+          Serial.println("WARNING: RotaryEncoder already initialized. Ignoring.");
+          return;
+        }
+        pin = swPin;
+        DT = dtPin;
+        CLK = clkPin;
+
+        pinMode(pin, INPUT_PULLUP);
+        pinMode(DT, INPUT_PULLUP);
+        pinMode(CLK, INPUT_PULLUP);
+
+        // Initialize button state to match actual pin state
+        state = drDigitalRead(pin);
+        oldState = state;
+
+        lastStateCLK = drDigitalRead(CLK);
+        initialized = true;
+
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("Setup Rotary Encoder SW:");
+          DR_DEBUG_PRINT(pin);
+          DR_DEBUG_PRINT(" DT:");
+          DR_DEBUG_PRINT(DT);
+          DR_DEBUG_PRINT(" CLK:");
+          DR_DEBUG_PRINT(CLK);
+          DR_DEBUG_PRINT(" initial button state: ");
+          DR_DEBUG_PRINTLN(state);
+        #endif
+      }
+
+      #if TOTAL_SUBSCRIBERS > 0
+        // Publishes rotation as well as the push button's presses
+        RotaryEncoder& publishTo(byte busTopic) {
+          topic = busTopic;
+          return *this;
+        }
+      #endif
+
+      RotaryEncoder& onClockwise(Delegate<void()> callback) {
+        CW.set(callback);
+        return *this;
+      }
+
+      RotaryEncoder& onClockwise(contextCallback callback, void* ctx) {
+        CW.set(callback, ctx);
+        return *this;
+      }
+
+      RotaryEncoder& onCounterClockwise(Delegate<void()> callback) {
+        CCW.set(callback);
+        return *this;
+      }
+
+      RotaryEncoder& onCounterClockwise(contextCallback callback, void* ctx) {
+        CCW.set(callback, ctx);
+        return *this;
+      }
+
+      void update() {
+        checkForPress();
+
+        currentStateCLK = drDigitalRead(CLK);
+
+        // If last and current state of CLK are different, then pulse occurred
+        // React to only 1 state change to avoid double count
+        if (currentStateCLK != lastStateCLK && currentStateCLK == 1) {
+          // Apply debouncing to rotation events (shorter delay than button press)
+          // Note: (millis() - lastRotationTime) handles millis() rollover correctly
+          if ((millis() - lastRotationTime) >= ENCODER_DEBOUNCE_DELAY) {
+            lastRotationTime = millis();
+
+            // If the DT state is different than the CLK state then
+            // the encoder is rotating CCW
+            if (drDigitalRead(DT) != currentStateCLK) {
+              DR_TRACE_EVENT(DR_EV_CCW, 0);
+              if (CCW.isSet()) {
+                DR_CALLBACK(DR_SRC_ENCODER_CB, CCW(handle));
+              }
+              DR_PUBLISH(DR_SRC_ENCODER_CB, DR_EV_CCW, 0);
+              #ifdef DEVICE_REACTOR_DEBUG
+                DR_DEBUG_PRINTLN("Encoder CCW");
+              #endif
+            } else {  // Encoder is rotating CW
+              DR_TRACE_EVENT(DR_EV_CW, 0);
+              if (CW.isSet()) {
+                DR_CALLBACK(DR_SRC_ENCODER_CB, CW(handle));
+              }
+              DR_PUBLISH(DR_SRC_ENCODER_CB, DR_EV_CW, 0);
+              #ifdef DEVICE_REACTOR_DEBUG
+                DR_DEBUG_PRINTLN("Encoder CW");
+              #endif
+            }
+          } else {
+            #ifdef DEVICE_REACTOR_DEBUG
+              DR_DEBUG_PRINTLN("ENCODER ROTATION DEBOUNCE PROTECTION");
+            #endif
+          }
+        }
+
+        // Remember last CLK state
+        lastStateCLK = currentStateCLK;
+      }
+
+    private:
+      byte currentStateCLK;
+      byte lastStateCLK;
+      unsigned long lastRotationTime = 0;
+      CallbackSlot<> CW;
+      CallbackSlot<> CCW;
+  };
+
+/*****************************************************************************
+ * PIXEL STRIP CLASS
+ *****************************************************************************/
+#if TOTAL_PIXEL_STRIPS > 0
+  class PixelStrip {
+    public:
+      byte type = PIXEL_WS2812;
+      byte dataPin, clockPin;
+      byte handle = INVALID_HANDLE;  // Set by the device, passed to context callbacks
+
+      void init(byte newType, byte newDataPin, byte newClockPin, unsigned int pixelCount) {
+        if (initialized) {
+          Serial.println("WARNING: PixelStrip already initialized. Ignoring.");
+          return;
+        }
+        type = newType;
+        dataPin = newDataPin;
+        clockPin = newClockPin;
+        count = (pixelCount > MAX_PIXELS_PER_STRIP) ? MAX_PIXELS_PER_STRIP : pixelCount;
+        memset(frame, 0, sizeof(frame));
+
+        if (type == PIXEL_WS2812) {
+          pinMode(dataPin, OUTPUT);
+          digitalWrite(dataPin, LOW);
+          #if defined(__AVR__)
+            port = portOutputRegister(digitalPinToPort(dataPin));
+            portMask = digitalPinToBitMask(dataPin);
+          #endif
+        } else if (type == PIXEL_APA102) {
+          #ifdef DEVICE_REACTOR_USE_SPI
+            SPI.begin();
+          #else
+            pinMode(dataPin, OUTPUT);
+            pinMode(clockPin, OUTPUT);
+          #endif
+        }
+
+        // Push the blank frame so the strip starts in a known state
+        dirty = true;
+        initialized = true;
+
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("Setup pixel strip type ");
+          DR_DEBUG_PRINT(type);
+          DR_DEBUG_PRINT(" on pin ");
+          DR_DEBUG_PRINT(dataPin);
+          DR_DEBUG_PRINT(" pixels: ");
+          DR_DEBUG_PRINTLN(count);
+        #endif
+      }
+
+      PixelStrip& setPixel(unsigned int index, byte r, byte g, byte b) {
+        if (index >= count) {
+          return *this;
+        }
+        byte* p = &frame[index * 3];
+        // Only mark dirty on a real change so steady frames are never re-sent
+        if (p[0] != g || p[1] != r || p[2] != b) {
+          p[0] = g;
+          p[1] = r;
+          p[2] = b;
+          dirty = true;
+        }
+        return *this;
+      }
+
+      PixelStrip& fill(byte r, byte g, byte b) {
+        for (unsigned int i = 0; i < count; i++) {
+          setPixel(i, r, g, b);
+        }
+        return *this;
+      }
+
+      PixelStrip& clear() {
+        return fill(0, 0, 0);
+      }
+
+      PixelStrip& setBrightness(byte newBrightness) {
+        if (brightness != newBrightness) {
+          brightness = newBrightness;
+          dirty = true;
+        }
+        return *this;
+      }
+
+      // Minimum time between two pushes; bounds how often a busy frame can stall update()
+      PixelStrip& frameInterval(unsigned long ms) {
+        minFrameInterval = ms;
+        return *this;
+      }
+
+      PixelStrip& onFrame(Delegate<void(const byte*, unsigned int)> callback) {
+        framePushed.set(callback);
+        return *this;
+      }
+
+      PixelStrip& onFrame(contextFrameCallback callback, void* ctx) {
+        framePushed.set(callback, ctx);
+        return *this;
+      }
+
+      byte red(unsigned int index) {
+        return (index < count) ? frame[index * 3 + 1] : 0;
+      }
+
+      byte green(unsigned int index) {
+        return (index < count) ? frame[index * 3] : 0;
+      }
+
+      byte blue(unsigned int index) {
+        return (index < count) ? frame[index * 3 + 2] : 0;
+      }
+
+      unsigned int length() {
+        return count;
+      }
+
+      bool isDirty() {
+        return dirty;
+      }
+
+      unsigned long framesShown() {
+        return frames;
+      }
+
+      // Push the frame now if anything changed, ignoring frameInterval()
+      void show() {
+        if (!dirty) {
+          return;
+        }
+        dirty = false;
+        lastFrameTime = millis();
+        frames++;
+
+        if (type == PIXEL_WS2812) {
+          sendWS2812();
+        } else if (type == PIXEL_APA102) {
+          sendAPA102();
+        }
+
+        DR_TRACE_EVENT(DR_EV_SHOW, count);
+        if (framePushed.isSet()) {
+          DR_CALLBACK(DR_SRC_PIXEL_CB, framePushed(handle, frame, count));
+        }
+      }
+
+      // Called once per Device::update(), after every LED has written its pixel
+      void update() {
+        // Note: (millis() - lastFrameTime) handles millis() rollover correctly
+        if (dirty && (millis() - lastFrameTime) >= minFrameInterval) {
+          show();
+        }
+      }
+
+    private:
+      bool initialized = false;
+      bool dirty = false;
+      byte brightness = 255;
+      unsigned int count = 0;
+      unsigned long lastFrameTime = 0;
+      unsigned long minFrameInterval = 0;
+      unsigned long frames = 0;
+      CallbackSlot<const byte*, unsigned int> framePushed;
+      byte frame[MAX_PIXELS_PER_STRIP * 3];  // GRB order, the WS2812 wire order
+
+      #if defined(__AVR__)
+        volatile uint8_t* port;
+        uint8_t portMask;
+      #endif
+
+      byte scale(byte value) {
+        return drScale8(value, brightness);
+      }
+
+      void sendWS2812() {
+        #if defined(__AVR__) && (F_CPU == 16000000L)
+          // ~20 cycles (1.25us) per bit: 0 = 5 high/15 low, 1 = 12 high/7 low. Interrupts
+          // must stay off for the whole frame or the strip latches early.
+          uint8_t hi = *port | portMask;
+          uint8_t lo = *port & ~portMask;
+          uint8_t oldSREG = SREG;
+          cli();
+          for (unsigned int i = 0; i < count * 3; i++) {
+            uint8_t value = scale(frame[i]);
+            uint8_t bits = 8;
+            asm volatile(
+              "1:                   \n\t"
+              "st   %a[port], %[hi] \n\t"
+              "nop                  \n\t"
+              "nop                  \n\t"
+              "sbrs %[value], 7     \n\t"
+              "st   %a[port], %[lo] \n\t"
+              "lsl  %[value]        \n\t"
+              "nop                  \n\t"
+              "nop                  \n\t"
+              "nop                  \n\t"
+              "nop                  \n\t"
+              "nop                  \n\t"
+              "st   %a[port], %[lo] \n\t"
+              "nop                  \n\t"
+              "nop                  \n\t"
+              "dec  %[bits]         \n\t"
+              "brne 1b              \n\t"
+              : [value] "+r" (value), [bits] "+r" (bits)
+              : [port] "e" (port), [hi] "r" (hi), [lo] "r" (lo)
+            );
+          }
+          SREG = oldSREG;
+        #endif
+      }
+
+      void writeByte(byte value) {
+        #ifdef DEVICE_REACTOR_USE_SPI
+          SPI.transfer(value);
+        #else
+          shiftOut(dataPin, clockPin, MSBFIRST, value);
+        #endif
+      }
+
+      void sendAPA102() {
+        #ifdef DEVICE_REACTOR_USE_SPI
+          SPI.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
+        #endif
+        // Start frame
+        for (byte i = 0; i < 4; i++) {
+          writeByte(0x00);
+        }
+        // Pixels: full 5-bit global brightness, scaling is done per channel
+        for (unsigned int i = 0; i < count; i++) {
+          const byte* p = &frame[i * 3];
+          writeByte(0xFF);
+          writeByte(scale(p[2]));
+          writeByte(scale(p[0]));
+          writeByte(scale(p[1]));
+        }
+        // End frame: one extra clock edge per two pixels
+        for (unsigned int i = 0; i < (count + 15) / 16; i++) {
+          writeByte(0x00);
+        }
+        #ifdef DEVICE_REACTOR_USE_SPI
+          SPI.endTransaction();
+        #endif
+      }
+  };
+#endif
+
+/*****************************************************************************
+ * SHIFT REGISTER BANK CLASS
+ *****************************************************************************/
+#if TOTAL_SHIFT_REGISTERS > 0
+  // A chain of 74HC595s seen as one bit array. Bit 0 is Q0 of the chip wired
+  // to the microcontroller, bit 8 is Q0 of the next chip, and so on.
+  class ShiftRegisterBank {
+    public:
+      byte dataPin, clockPin, latchPin;
+
+      void init(byte newDataPin, byte newClockPin, byte newLatchPin) {
+        if (initialized) {
+          Serial.println("WARNING: Shift registers already initialized. Ignoring.");
+          return;
+        }
+        dataPin = newDataPin;
+        clockPin = newClockPin;
+        latchPin = newLatchPin;
+
+        pinMode(latchPin, OUTPUT);
+        digitalWrite(latchPin, LOW);
+        #ifdef DEVICE_REACTOR_USE_SPI
+          SPI.begin();
+        #else
+          pinMode(dataPin, OUTPUT);
+          pinMode(clockPin, OUTPUT);
+        #endif
+
+        // Latch the current bits (all off unless LEDs were set up first)
+        dirty = true;
+        initialized = true;
+
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("Setup shift registers, latch pin ");
+          DR_DEBUG_PRINT(latchPin);
+          DR_DEBUG_PRINT(" chips: ");
+          DR_DEBUG_PRINTLN(TOTAL_SHIFT_REGISTERS);
+        #endif
+      }
+
+      void setBit(byte bit, bool on) {
+        if (bit >= TOTAL_SHIFT_REGISTERS * 8) {
+          return;
+        }
+        byte mask = 1 << (bit & 7);
+        byte old = bits[bit >> 3];
+        bits[bit >> 3] = on ? (old | mask) : (old & ~mask);
+        if (bits[bit >> 3] != old) {
+          dirty = true;
+        }
+      }
+
+      bool getBit(byte bit) {
+        if (bit >= TOTAL_SHIFT_REGISTERS * 8) {
+          return false;
+        }
+        return bits[bit >> 3] & (1 << (bit & 7));
+      }
+
+      // Shift out and latch now if any bit changed
+      void latch() {
+        if (!dirty || !initialized) {
+          return;
+        }
+        dirty = false;
+
+        #ifdef DEVICE_REACTOR_USE_SPI
+          SPI.beginTransaction(SPISettings(8000000, MSBFIRST, SPI_MODE0));
+        #endif
+        // The first byte out ends up in the last chip of the chain
+        for (byte i = TOTAL_SHIFT_REGISTERS; i > 0; i--) {
+          #ifdef DEVICE_REACTOR_USE_SPI
+            SPI.transfer(bits[i - 1]);
+          #else
+            shiftOut(dataPin, clockPin, MSBFIRST, bits[i - 1]);
+          #endif
+        }
+        #ifdef DEVICE_REACTOR_USE_SPI
+          SPI.endTransaction();
+        #endif
+        digitalWrite(latchPin, HIGH);
+        digitalWrite(latchPin, LOW);
+      }
+
+      // Called once per Device::update(), after all outputs were written
+      void update() {
+        latch();
+      }
+
+    private:
+      bool initialized = false;
+      bool dirty = false;
+      byte bits[TOTAL_SHIFT_REGISTERS] = {0};
+  };
+#endif
+
+/*****************************************************************************
+ * CHARLIEPLEXED ARRAY CLASS
+ *****************************************************************************/
+#if TOTAL_CHARLIE_ARRAYS > 0
+  // n pins drive n * (n - 1) LEDs. One row (one anode pin) is lit per time
+  // slice; LED index = row * (n - 1) + k, where cathode k skips the row's pin.
+  class CharlieArray {
+    public:
+      void init(const byte* newPins, byte count) {
+        if (initialized) {
+          Serial.println("WARNING: CharlieArray already initialized. Ignoring.");
+          return;
+        }
+        pinCount = (count > MAX_CHARLIE_PINS) ? MAX_CHARLIE_PINS : count;
+        for (byte i = 0; i < pinCount; i++) {
+          pins[i] = newPins[i];
+        }
+        memset(frame, 0, sizeof(frame));
+        blank();
+        initialized = true;
+
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("Setup charlieplexed array, pins: ");
+          DR_DEBUG_PRINT(pinCount);
+          DR_DEBUG_PRINT(" LEDs: ");
+          DR_DEBUG_PRINTLN(size());
+        #endif
+      }
+
+      CharlieArray& setLed(byte index, bool on) {
+        if (index >= size()) {
+          return *this;
+        }
+        if (on) {
+          frame[index >> 3] |= (1 << (index & 7));
+        } else {
+          frame[index >> 3] &= ~(1 << (index & 7));
+        }
+        return *this;
+      }
+
+      bool getLed(byte index) {
+        if (index >= size()) {
+          return false;
+        }
+        return frame[index >> 3] & (1 << (index & 7));
+      }
+
+      CharlieArray& clear() {
+        memset(frame, 0, sizeof(frame));
+        return *this;
+      }
+
+      // Duty cycle of each slice, 0-255. Shared by every LED of the array.
+      CharlieArray& setBrightness(byte newBrightness) {
+        brightness = newBrightness;
+        return *this;
+      }
+
+      // Time each row stays selected. A full refresh takes pins * sliceTime.
+      CharlieArray& sliceTime(unsigned int us) {
+        sliceMicros = (us < 16) ? 16 : us;
+        return *this;
+      }
+
+      // Stop refreshing from Device::update(); call refresh() from a timer ISR
+      // instead, at 16 ticks per slice, for flicker-free output
+      CharlieArray& refreshFromInterrupt() {
+        externalRefresh = true;
+        return *this;
+      }
+
+      byte size() {
+        return pinCount * (pinCount - 1);
+      }
+
+      // One ISR tick: a slice is 16 ticks, lit for the first brightness / 16
+      void refresh() {
+        if (!initialized) {
+          return;
+        }
+        if (tick == 0) {
+          nextRow();
+        } else if (tick == ((brightness + 15) >> 4)) {
+          blank();
+        }
+        tick = (tick + 1) & 0x0F;
+      }
+
+      void update() {
+        if (externalRefresh || !initialized) {
+          return;
+        }
+        unsigned long elapsed = micros() - sliceStart;
+        if (elapsed >= sliceMicros) {
+          sliceStart = micros();
+          nextRow();
+        } else if (rowLit && brightness < 255 &&
+                   elapsed >= ((unsigned long)sliceMicros * brightness) >> 8) {
+          blank();
+        }
+      }
+
+    private:
+      bool initialized = false;
+      bool externalRefresh = false;
+      bool rowLit = false;
+      byte pins[MAX_CHARLIE_PINS];
+      byte pinCount = 0;
+      byte frame[(MAX_CHARLIE_PINS * (MAX_CHARLIE_PINS - 1) + 7) / 8];
+      byte row = 0;
+      byte tick = 0;
+      byte brightness = 255;
+      unsigned int sliceMicros = 1000;
+      unsigned long sliceStart = 0;
+
+      void blank() {
+        for (byte i = 0; i < pinCount; i++) {
+          pinMode(pins[i], INPUT);
+          digitalWrite(pins[i], LOW);  // No pull-up, or unlit LEDs glow
+        }
+        rowLit = false;
+      }
+
+      void nextRow() {
+        blank();
+        row = (row + 1 < pinCount) ? row + 1 : 0;
+        if (brightness == 0) {
+          return;
+        }
+
+        byte base = row * (pinCount - 1);
+        for (byte k = 0; k < pinCount - 1; k++) {
+          if (getLed(base + k)) {
+            byte cathode = (k < row) ? k : k + 1;
+            pinMode(pins[cathode], OUTPUT);
+            rowLit = true;
+          }
+        }
+        // Rows with nothing lit leave every pin floating
+        if (rowLit) {
+          pinMode(pins[row], OUTPUT);
+          digitalWrite(pins[row], HIGH);
+        }
+      }
+  };
+#endif
+
+/*****************************************************************************
+ * OUTPUT BATCH CLASS
+ *****************************************************************************/
+#ifdef DR_FAST_OUTPUT_ENABLED
+  // Largest AVR port number (PL on the Mega is 12)
+  #define DR_MAX_PORTS 13
+
+  // Collects on/off writes for a whole Device::update() pass as per-port set and
+  // clear masks, then applies them with one register write per touched port
+  class OutputBatch {
+    public:
+      void begin() {
+        batching = true;
+      }
+
+      void write(byte port, byte mask, bool high) {
+        if (!batching) {
+          // Outside update() (e.g. in setup()) write through immediately
+          volatile uint8_t* out = portOutputRegister(port);
+          uint8_t oldSREG = SREG;
+          cli();
+          if (high) {
+            *out |= mask;
+          } else {
+            *out &= ~mask;
+          }
+          SREG = oldSREG;
+          return;
+        }
+
+        // Last write in the pass wins
+        if (high) {
+          setMasks[port] |= mask;
+          clearMasks[port] &= ~mask;
+        } else {
+          clearMasks[port] |= mask;
+          setMasks[port] &= ~mask;
+        }
+        dirtyPorts |= (1 << port);
+      }
+
+      void flush() {
+        batching = false;
+        if (dirtyPorts == 0) {
+          return;
+        }
+        for (byte port = 0; port < DR_MAX_PORTS; port++) {
+          if (dirtyPorts & (1 << port)) {
+            volatile uint8_t* out = portOutputRegister(port);
+            // Read-modify-write with interrupts off so an ISR touching the
+            // same port between the read and the write isn't lost
+            uint8_t oldSREG = SREG;
+            cli();
+            *out = (*out | setMasks[port]) & ~clearMasks[port];
+            SREG = oldSREG;
+            setMasks[port] = 0;
+            clearMasks[port] = 0;
+          }
+        }
+        dirtyPorts = 0;
+      }
+
+    private:
+      bool batching = false;
+      uint16_t dirtyPorts = 0;
+      byte setMasks[DR_MAX_PORTS] = {0};
+      byte clearMasks[DR_MAX_PORTS] = {0};
+  };
+#endif
+
+/*****************************************************************************
+ * LED CLASS
+ *****************************************************************************/
+  class LED {
+    public:
+      byte pin, pinG, pinB;
+      byte handle = INVALID_HANDLE;  // Set by the device, passed to context callbacks
+      byte R = 0, G = 0, B = 0;  // Initialize RGB values to prevent undefined behavior
+      bool isRGB = false;
+      bool isDimmable = false;
+      bool commonAnode = true;
+
+      // Regular LED initialization
+      void init(byte newPin) {
+        if (initialized) {
+          Serial.println("WARNING: LED already initialized. Ignoring.");
+          return;
+        }
+        pin = newPin;
+        pinMode(pin, OUTPUT);
+        setState(LOW);  // Always through digitalWrite(), which also stops any PWM timer on the pin
+        initialized = true;
+
+        #ifdef DR_FAST_OUTPUT_ENABLED
+          fastPort = digitalPinToPort(pin);
+          fastMask = digitalPinToBitMask(pin);
+        #endif
+
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("Setup LED on pin ");
+          DR_DEBUG_PRINTLN(pin);
+        #endif
+      }
+
+      // RGB LED initialization
+      void init(byte newPinR, byte newPinG, byte newPinB) {
+        if (initialized) {
+          Serial.println("WARNING: LED already initialized. Ignoring.");
+          return;
+        }
+        pin = newPinR;
+        pinMode(pin, OUTPUT);
+        pinG = newPinG;
+        pinMode(pinG, OUTPUT);
+        pinB = newPinB;
+        pinMode(pinB, OUTPUT);
+        isRGB = true;
+        setState(LOW);
+        initialized = true;
+
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("Setup RGB LED on pins ");
+          DR_DEBUG_PRINT(pin);
+          DR_DEBUG_PRINT(",");
+          DR_DEBUG_PRINT(pinG);
+          DR_DEBUG_PRINT(",");
+          DR_DEBUG_PRINTLN(pinB);
+        #endif
+      }
+
+      #if TOTAL_PIXEL_STRIPS > 0
+        // Pixel LED initialization: drives one pixel of a strip's frame buffer
+        // instead of pins, so blink/pulse/fade work per pixel
+        void init(PixelStrip* newStrip, unsigned int newPixel) {
+          if (initialized) {
+            Serial.println("WARNING: LED already initialized. Ignoring.");
+            return;
+          }
+          strip = newStrip;
+          pixel = newPixel;
+          isRGB = true;
+          commonAnode = false;
+          R = G = B = 255;  // White until setColor() is called
+          setState(LOW);
+          initialized = true;
+
+          #ifdef DEVICE_REACTOR_DEBUG
+            DR_DEBUG_PRINT("Setup pixel LED on pixel ");
+            DR_DEBUG_PRINTLN(pixel);
+          #endif
+        }
+      #endif
+
+      #if TOTAL_SHIFT_REGISTERS > 0
+        // Shift register LED initialization: drives one output bit of the bank,
+        // so blink() and flip() cost a bit operation instead of a pin write
+        void init(ShiftRegisterBank* newBank, byte newBit) {
+          if (initialized) {
+            Serial.println("WARNING: LED already initialized. Ignoring.");
+            return;
+          }
+          shiftBank = newBank;
+          shiftBit = newBit;
+          setState(LOW);
+          initialized = true;
+
+          #ifdef DEVICE_REACTOR_DEBUG
+            DR_DEBUG_PRINT("Setup shift register LED on bit ");
+            DR_DEBUG_PRINTLN(shiftBit);
+          #endif
+        }
+      #endif
+
+      // Output-less initialization: runs the blink/pulse/fade engine without
+      // touching hardware. Used by LedGroup as its shared timing engine.
+      void initVirtual() {
+        if (initialized) {
+          Serial.println("WARNING: LED already initialized. Ignoring.");
+          return;
+        }
+        isVirtual = true;
+        initialized = true;
+      }
+
+      #if TOTAL_CHARLIE_ARRAYS > 0
+        // Charlieplexed LED initialization: drives one LED of a CharlieArray
+        void init(CharlieArray* newArray, byte newIndex) {
+          if (initialized) {
+            Serial.println("WARNING: LED already initialized. Ignoring.");
+            return;
+          }
+          charlie = newArray;
+          charlieIndex = newIndex;
+          setState(LOW);
+          initialized = true;
+
+          #ifdef DEVICE_REACTOR_DEBUG
+            DR_DEBUG_PRINT("Setup charlieplexed LED ");
+            DR_DEBUG_PRINTLN(charlieIndex);
+          #endif
+        }
+      #endif
+
+      void turnOn() {
+        setState(HIGH);
+      }
+
+      void turnOff() {
+        clearBlink();
+        clearPulse();
+        colorEffect = COLOR_NONE;
+        setState(LOW);
+      }
+
+      void flip() {
+        if (state == HIGH) {
+          setState(LOW);
+        } else {
+          setState(HIGH);
+        }
+      }
+
+      LED& setLevel(byte newLevel) {
+        isDimmable = true;
+        level = newLevel;
+        ditherFrac = 0;
+
+        // If the LED is already on, update the brightness
+        if (state == HIGH) {
+          setState(HIGH);
+        }
+
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("LED level: ");
+          DR_DEBUG_PRINTLN(level);
+        #endif
+
+        return *this;
+      }
+
+      // Smooth low-brightness fades: pulse/fade levels keep 4 fractional bits and
+      // are dithered over update passes (~12-bit brightness on 8-bit PWM)
+      LED& dither(bool enabled = true) {
+        dithering = enabled;
+        if (!enabled) {
+          ditherFrac = 0;
+        }
+        return *this;
+      }
+
+      // Set a 12-bit level (0-4080, i.e. level * 16 + fraction), dithered
+      LED& setLevelFine(unsigned int newLevel) {
+        if (newLevel > 4080) {
+          newLevel = 4080;
+        }
+        setLevel(newLevel >> 4);
+        ditherFrac = newLevel & 0x0F;
+        if (ditherFrac != 0) {
+          wake();
+        }
+        return *this;
+      }
+
+      LED& setColor(byte newR, byte newG, byte newB) {
+        // An explicit color ends any running crossfade or hue cycle
+        colorEffect = COLOR_NONE;
+
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINT("RGB Color: ");
+          DR_DEBUG_PRINT(newR);
+          DR_DEBUG_PRINT(",");
+          DR_DEBUG_PRINT(newG);
+          DR_DEBUG_PRINT(",");
+          DR_DEBUG_PRINTLN(newB);
+        #endif
+
+        applyColor(newR, newG, newB);
+        return *this;
+      }
+
+      // Hue in degrees (0-359), saturation and value 0-255
+      LED& setHSV(unsigned int hue, byte sat, byte val) {
+        byte r, g, b;
+        hsvToRgb(hue, sat, val, r, g, b);
+        return setColor(r, g, b);
+      }
+
+      // Crossfade from the current color to the target color over duration ms
+      LED& colorFade(byte newR, byte newG, byte newB, unsigned long duration) {
+        fromR = R;
+        fromG = G;
+        fromB = B;
+        toR = newR;
+        toG = newG;
+        toB = newB;
+        colorDuration = (duration < 1) ? 1 : duration;
+        colorStartTime = millis();
+        colorEffect = COLOR_FADE;
+        wake();
+        if (!blinking && !pulsing) {
+          setState(HIGH);
+        }
+        return *this;
+      }
+
+      // Walk the full color wheel once every period ms, until setColor() or turnOff()
+      LED& hueCycle(unsigned long period, byte sat = 255, byte val = 255) {
+        colorDuration = (period < 1) ? 1 : period;
+        hueSat = sat;
+        hueVal = val;
+        colorStartTime = millis();
+        colorEffect = COLOR_HUE_CYCLE;
+        wake();
+        if (!blinking && !pulsing) {
+          setState(HIGH);
+        }
+        return *this;
+      }
+
+      // Integer HSV to RGB conversion (no floating point)
+      static void hsvToRgb(unsigned int hue, byte sat, byte val, byte& r, byte& g, byte& b) {
+        hue %= 360;
+        byte sector = hue / 60;
+        byte rem = ((hue % 60) * 255) / 60;  // Position inside the sector, 0-250
+
+        byte p = drScale8(val, 255 - sat);
+        byte q = drScale8(val, 255 - drScale8(sat, rem));
+        byte t = drScale8(val, 255 - drScale8(sat, 255 - rem));
+
+        switch (sector) {
+          case 0:  r = val; g = t;   b = p;   break;
+          case 1:  r = q;   g = val; b = p;   break;
+          case 2:  r = p;   g = val; b = t;   break;
+          case 3:  r = p;   g = q;   b = val; break;
+          case 4:  r = t;   g = p;   b = val; break;
+          default: r = val; g = p;   b = q;   break;
+        }
+      }
+
+      LED& setCommonAnode(bool isCommonAnode) {
+        commonAnode = isCommonAnode;
+        return *this;
+      }
+
+      LED& pulse(unsigned long pDelay, unsigned int count, byte low, byte high) {
+        initPulse(pDelay, count, low, high);
+        return *this;
+      }
+
+      LED& fadeIn(unsigned long duration) {
+        return fadeIn(duration, 255);
+      }
+
+      LED& fadeIn(unsigned long duration, byte targetLevel) {
+        // Fade from 0 to targetLevel over duration ms (one-shot fade)
+        initFade(duration, 0, targetLevel);
+        return *this;
+      }
+
+      LED& fadeOut(unsigned long duration) {
+        // Only fade out if LED is actually on, otherwise do nothing
+        if (state == LOW) {
+          return *this;  // Already off, no fade needed
+        }
+
+        // Fade from current level to 0 over duration ms
+        // Determine start level: use current level if dimmable, otherwise 255
+        byte startLevel = (isDimmable && level > 0) ? level : 255;
+
+        initFade(duration, startLevel, 0);
         return *this;
       }
 
-      AnalogSensor& quantize(int step, int hysteresis) {
-        quantizeStep = step;
-        hysteresis_amount = hysteresis;
+      LED& blink(unsigned long delay) {
+        initBlink(delay, 0);
         return *this;
       }
 
-      AnalogSensor& changeThreshold(int threshold) {
-        delta = threshold;
+      LED& blink(unsigned long delay, unsigned int count) {
+        initBlink(delay, count);
         return *this;
       }
 
-      AnalogSensor& smoothing(byte samples) {
-        avgSamples = samples < 1 ? 1 : samples;
+      bool isOn() {
+        return state == HIGH;
+      }
+
+      // True while an effect needs update() calls (Device skips idle LEDs)
+      bool isBusy() {
+        return blinking || pulsing || patternMask != 0 ||
+               colorEffect != COLOR_NONE || ditherFrac != 0 || ditherBump != 0;
+      }
+
+      // Called from update() once the LED goes idle, whether its effect ran
+      // out or was stopped; starting a new effect from here is fine
+      LED& onDone(Delegate<void()> callback) {
+        done.set(callback);
+        return *this;
+      }
+
+      LED& onDone(contextCallback callback, void* ctx) {
+        done.set(callback, ctx);
+        return *this;
+      }
+
+      byte getLevel() {
+        return level;
+      }
+
+      // Play a bit sequence, one bit per unitMs, from the highest set bit down to
+      // bit 0 (1 = on). repeat = 0 plays forever. e.g. 0b1010101110 = 3 short, 1 long
+      LED& pattern(uint32_t bits, unsigned long unitMs, unsigned int repeat = 0) {
+        clearBlink();
+        clearPulse();
+        if (bits == 0) {
+          setState(LOW);
+          return *this;
+        }
+        // Pattern playback shares the effect timer and counters
+        patternBits = bits;
+        patternMask = topBit(bits);
+        wake();
+        effectStep = (unitMs < 1) ? 1 : unitMs;
+        effectMax = repeat;
+        effectCount = 0;
+        effectTime = millis();
+        setState(HIGH);  // The top bit is always set
         return *this;
       }
 
-      AnalogSensor& onChange(intParamCallback callback) {
-        hasChangeFunc = true;
-        changed = callback;
-        return *this;
+      // Compile text to a pattern() value at setup: dot = 1 unit on, dash = 3,
+      // 1 unit between elements, 3 between letters, 7 between words. Trailing
+      // silence (up to a word gap) is kept so repeats stay readable. Returns 0 if
+      // the text doesn't fit in 32 units ("SOS" fits).
+      static uint32_t morse(const char* text) {
+        uint32_t bits = 0;
+        byte length = 0;
+
+        for (const char* c = text; *c != '\0'; c++) {
+          char ch = *c;
+          if (ch == ' ') {
+            // Letters already end with 3 units of silence
+            if (!appendBits(bits, length, 0, 4)) return 0;
+            continue;
+          }
+          byte code;
+          if (ch >= 'a' && ch <= 'z') {
+            code = pgm_read_byte(&morseCodes()[ch - 'a']);
+          } else if (ch >= 'A' && ch <= 'Z') {
+            code = pgm_read_byte(&morseCodes()[ch - 'A']);
+          } else if (ch >= '0' && ch <= '9') {
+            code = pgm_read_byte(&morseCodes()[26 + ch - '0']);
+          } else {
+            continue;  // Unsupported character
+          }
+
+          byte elements = code >> 5;
+          for (byte i = elements; i > 0; i--) {
+            bool dash = code & (1 << (i - 1));
+            if (!appendBits(bits, length, dash ? 0x07 : 0x01, dash ? 3 : 1)) return 0;
+            if (i > 1 && !appendBits(bits, length, 0, 1)) return 0;
+          }
+          if (!appendBits(bits, length, 0, 3)) return 0;
+        }
+
+        // Stretch the final letter gap towards a word gap while it fits
+        while (length > 0 && length < 32 && (bits & 0x7F) != 0) {
+          bits <<= 1;
+          length++;
+        }
+        return bits;
+      }
+
+      void update() {
+        runBlink();
+        runPattern();
+        runPulse();
+        runDither();
+        runColor();
+      }
+
+    private:
+      #if TOTAL_LED_GROUPS > 0
+        friend class LedGroup;
+      #endif
+
+      // Morse table for morse(): element count in the top 3 bits, elements in
+      // the low bits, first element most significant (1 = dash). A-Z then 0-9.
+      static const byte* morseCodes() {
+        static const byte codes[] PROGMEM = {
+          0x41, 0x88, 0x8A, 0x64, 0x20, 0x82, 0x66, 0x80, 0x40, 0x87, 0x65, 0x84, 0x43,
+          0x42, 0x67, 0x86, 0x8D, 0x62, 0x60, 0x21, 0x61, 0x81, 0x63, 0x89, 0x8B, 0x8C,
+          0xBF, 0xAF, 0xA7, 0xA3, 0xA1, 0xA0, 0xB0, 0xB8, 0xBC, 0xBE
+        };
+        return codes;
+      }
+
+      bool initialized = false;
+      bool isVirtual = false;
+      byte state = LOW;
+      byte level = 255;  // Default to full brightness for intuitive turnOn() behavior
+      bool blinking = false;
+      bool pulsing = false;
+      bool pulseUp = true;
+      byte pulseLow = 0;
+      byte pulseHigh = 255;
+
+      bool dithering = false;
+      byte ditherFrac = 0;  // Fractional level, 1/16ths
+      byte ditherAcc = 0;
+      byte ditherBump = 0;  // 1 while this pass shows level + 1
+
+      // RGB color effects. Kept apart from the timer below: a color fade or
+      // hue cycle runs on top of a blink or pulse.
+      enum ColorEffect { COLOR_NONE, COLOR_FADE, COLOR_HUE_CYCLE };
+      byte colorEffect = COLOR_NONE;
+      byte fromR = 0, fromG = 0, fromB = 0;
+      byte toR = 0, toG = 0, toB = 0;
+      byte hueSat = 255, hueVal = 255;
+
+      // Blink, pattern and pulse/fade timer. Only one of them runs at a time
+      // (each clears the others when it starts), so they share it.
+      unsigned int effectCount = 0;  // Blink flips, pattern passes or pulse cycles done
+      unsigned int effectMax = 0;  // 0 = forever (pulse: 0 = one-way fade)
+      unsigned long effectTime = 0;  // Start of the current step
+      unsigned long effectStep = 0;  // Blink half-period, pattern unit or pulse half-period in ms
+      uint32_t patternBits = 0;
+      uint32_t patternMask = 0;  // Bit currently shown, 0 = no pattern running
+
+      unsigned long colorStartTime = 0;
+      unsigned long colorDuration = 0;  // Fade duration or hue cycle period
+
+      #if TOTAL_PIXEL_STRIPS > 0
+        PixelStrip* strip = nullptr;
+        unsigned int pixel = 0;
+      #endif
+
+      #if TOTAL_SHIFT_REGISTERS > 0
+        ShiftRegisterBank* shiftBank = nullptr;
+        byte shiftBit = 0;
+      #endif
+
+      #if TOTAL_CHARLIE_ARRAYS > 0
+        CharlieArray* charlie = nullptr;
+        byte charlieIndex = 0;
+      #endif
+
+      #ifdef DR_FAST_OUTPUT_ENABLED
+        OutputBatch* fastOutputs = nullptr;  // Set by Device::newLED()
+        byte fastPort = 0;
+        byte fastMask = 0;
+      #endif
+
+      // This LED's bit in Device's active list, set whenever an effect starts
+      byte* activeFlags = nullptr;
+      byte activeMask = 0;
+      CallbackSlot<> done;
+      template <class Cfg> friend class DeviceT;
+      template <byte N> friend class LedPool;
+
+      void wake() {
+        if (activeFlags != nullptr) {
+          *activeFlags |= activeMask;
+        }
+      }
+
+      void setState(byte newState) {
+        state = newState;
+
+        if (isVirtual) {
+          return;
+        }
+
+        byte outLevel = (ditherBump && level < 255) ? level + 1 : level;
+
+        #if TOTAL_PIXEL_STRIPS > 0
+          if (strip != nullptr) {
+            // Pixels are always dimmable: scale the color by level, the strip
+            // pushes the frame at the end of Device::update() if it changed
+            if (state == LOW) {
+              strip->setPixel(pixel, 0, 0, 0);
+            } else {
+              strip->setPixel(pixel, drScale8(R, outLevel), drScale8(G, outLevel), drScale8(B, outLevel));
+            }
+            return;
+          }
+        #endif
+
+        #if TOTAL_CHARLIE_ARRAYS > 0
+          if (charlie != nullptr) {
+            // Brightness is per array (slice duty), so only on/off here
+            charlie->setLed(charlieIndex, state == HIGH && (!isDimmable || level > 0));
+            return;
+          }
+        #endif
+
+        #if TOTAL_SHIFT_REGISTERS > 0
+          if (shiftBank != nullptr) {
+            // No PWM on a 595 output: any non-zero level counts as on
+            shiftBank->setBit(shiftBit, state == HIGH && (!isDimmable || level > 0));
+            return;
+          }
+        #endif
+
+        if (isRGB) {
+          if (state == LOW) {
+            byte val = 0;
+            if (commonAnode) {
+              val = 255;
+            }
+            analogWrite(pin, val);
+            analogWrite(pinG, val);
+            analogWrite(pinB, val);
+          } else {
+            // Scale by level so fadeIn()/pulse() work on RGB LEDs too
+            byte r = drScale8(R, outLevel);
+            byte g = drScale8(G, outLevel);
+            byte b = drScale8(B, outLevel);
+            if (commonAnode) {
+              r = 255 - r;
+              g = 255 - g;
+              b = 255 - b;
+            }
+            analogWrite(pin, r);
+            analogWrite(pinG, g);
+            analogWrite(pinB, b);
+          }
+        } else if (isDimmable) {
+          analogWrite(pin, (state == HIGH) ? outLevel : LOW);
+        } else {
+          #ifdef DR_FAST_OUTPUT_ENABLED
+            if (fastOutputs != nullptr) {
+              fastOutputs->write(fastPort, fastMask, state == HIGH);
+              return;
+            }
+          #endif
+          digitalWrite(pin, state);
+        }
+      }
+
+      void initPulse(unsigned long pDelay, unsigned int count, byte low, byte high) {
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINTLN("Initiate Pulse");
+        #endif
+
+        clearBlink();
+        clearPulse();
+
+        pulseLow = low;
+        pulseHigh = high;
+        effectMax = count;
+        // Guard against zero delay to prevent excessive updates
+        unsigned long safePDelay = (pDelay < 2) ? 2 : pDelay;
+        effectStep = safePDelay / 2;  // Half-period (time to go from low to high or vice versa)
+        effectTime = millis();
+        pulsing = true;
+        wake();
+
+        setLevel(pulseLow);
+        setState(HIGH);
+      }
+
+      void initFade(unsigned long duration, byte start, byte end) {
+        #ifdef DEVICE_REACTOR_DEBUG
+          DR_DEBUG_PRINTLN("Initiate Fade");
+        #endif
+
+        clearBlink();
+        clearPulse();
+
+        pulseLow = start;
+        pulseHigh = end;
+        effectMax = 0;  // Signifies a one-way fade
+        // Guard against zero duration to prevent division issues and excessive updates
+        effectStep = (duration < 1) ? 1 : duration;  // Use full duration (not halved like pulse)
+        effectTime = millis();
+        pulsing = true;
+        wake();
+        pulseUp = true;  // start -> end, runPulse() handles either direction
+
+        setLevel(start);
+        setState(HIGH);
+      }
+
+      void clearPulse() {
+        effectCount = 0;
+        effectMax = 0;
+        pulseLow = 0;
+        pulseHigh = 0;
+        effectStep = 0;
+        pulseUp = true;
+        pulsing = false;
+        // A leftover fraction would keep the LED dithering (and busy) forever
+        ditherFrac = 0;
+        ditherBump = 0;
+      }
+
+      // elapsed / duration as 12-bit fixed point (0-4095) for elapsed < duration.
+      // Long durations are scaled down first so the shift can't overflow 32 bits.
+      static unsigned int progress12(unsigned long elapsed, unsigned long duration) {
+        unsigned long progress = (duration < 0x100000UL)
+                                   ? (elapsed << 12) / duration
+                                   : elapsed / (duration >> 12);
+        return (progress > 4095) ? 4095 : progress;
+      }
+
+      void runPulse() {
+        if (pulsing) {
+          unsigned long elapsed = millis() - effectTime;
+
+          // Each half-period runs from one end to the other. One-way fades always
+          // run "up" from start (pulseLow) to end (pulseHigh), in either direction.
+          byte from = pulseUp ? pulseLow : pulseHigh;
+          byte to = pulseUp ? pulseHigh : pulseLow;
+
+          if (elapsed >= effectStep) {
+            if (effectMax == 0) {
+              // One-way fade finished
+              byte startLevel = pulseLow;
+              clearPulse();
+              if (to == 0) {
+                // fadeOut: turn off, keeping the level it faded from for turnOn()
+                level = startLevel;
+                setState(LOW);
+              } else {
+                level = to;
+                setState(HIGH);
+              }
+              return;
+            }
+            level = to;
+            ditherFrac = 0;
+            setState(HIGH);
+            if (!pulseUp) {
+              effectCount++;
+            }
+            pulseUp = !pulseUp;
+            effectTime = millis();
+          } else {
+            unsigned int progress = progress12(elapsed, effectStep);
+            // Level with 4 fractional bits (0-4080); the fraction feeds runDither()
+            unsigned int level12 = from * 16 + ((long)(to - from) * 16 * progress) / 4096;
+            byte desiredLevel = level12 >> 4;
+            ditherFrac = dithering ? (level12 & 0x0F) : 0;
+            if (level != desiredLevel) {
+              level = desiredLevel;
+              setState(HIGH);
+            }
+          }
+
+          // We've pulsed enough
+          if (effectCount >= effectMax && effectMax > 0) {
+            clearPulse();
+            setState(LOW);
+          }
+        }
+      }
+
+      // Temporal dithering: alternate between level and level + 1 so the average
+      // over a few passes matches the fractional level. One add and one compare.
+      void runDither() {
+        byte bump = 0;
+        if (ditherFrac != 0 && state == HIGH) {
+          ditherAcc += ditherFrac;
+          bump = ditherAcc >> 4;
+          ditherAcc &= 0x0F;
+        }
+        if (bump != ditherBump) {
+          ditherBump = bump;
+          if (state == HIGH) {
+            setState(HIGH);
+          }
+        }
+      }
+
+      // Store the raw color and refresh the hardware only if it is lit and changed
+      void applyColor(byte newR, byte newG, byte newB) {
+        if (newR == R && newG == G && newB == B) {
+          return;
+        }
+        R = newR;
+        G = newG;
+        B = newB;
+        if (state == HIGH) {
+          setState(HIGH);
+        }
+      }
+
+      void runColor() {
+        if (colorEffect == COLOR_NONE) {
+          return;
+        }
+        unsigned long elapsed = millis() - colorStartTime;
+
+        if (colorEffect == COLOR_FADE) {
+          if (elapsed >= colorDuration) {
+            colorEffect = COLOR_NONE;
+            applyColor(toR, toG, toB);
+            return;
+          }
+          // 12-bit progress, then per-channel interpolation
+          unsigned int t = progress12(elapsed, colorDuration);
+          // long math: a 255 * 4095 channel step overflows a 16-bit int on AVR
+          applyColor(fromR + (((long)toR - fromR) * t >> 12),
+                     fromG + (((long)toG - fromG) * t >> 12),
+                     fromB + (((long)toB - fromB) * t >> 12));
+        } else {
+          unsigned int hue = ((unsigned long)progress12(elapsed % colorDuration, colorDuration) * 360UL) >> 12;
+          byte r, g, b;
+          hsvToRgb(hue, hueSat, hueVal, r, g, b);
+          applyColor(r, g, b);
+        }
+      }
+
+      void initBlink(unsigned long bDelay, unsigned int count) {
+        clearBlink();
+        clearPulse();
+        effectCount = 0;
+        // For finite blinks: ensure LED ends OFF after count blinks
+        // If currently OFF, need count*2 flips. If currently ON, need count*2-1 flips to end OFF
+        if (count > 0) {
+          effectMax = (state == HIGH) ? (count * 2 - 1) : (count * 2);
+        } else {
+          effectMax = 0;  // Infinite blink
+        }
+        // Guard against zero delay to prevent excessive toggling
+        unsigned long safeBDelay = (bDelay < 1) ? 1 : bDelay;
+        effectStep = safeBDelay / 2;  // Since we need to flip
+        effectTime = millis();  // Wait for first interval before starting
+        blinking = true;
+        wake();
+      }
+
+      void clearBlink() {
+        patternMask = 0;
+        effectCount = 0;
+        effectMax = 0;
+        effectTime = 0;
+        effectStep = 0;
+        blinking = false;
+      }
+
+      void runPattern() {
+        // Note: (millis() - effectTime) handles millis() rollover correctly
+        if (patternMask != 0 && millis() - effectTime >= effectStep) {
+          effectTime = millis();
+          patternMask >>= 1;
+
+          if (patternMask == 0) {
+            // One pass done: stop after the last repeat, otherwise start over
+            effectCount++;
+            if (effectMax > 0 && effectCount >= effectMax) {
+              setState(LOW);
+              return;
+            }
+            patternMask = topBit(patternBits);
+          }
+
+          byte newState = (patternBits & patternMask) ? HIGH : LOW;
+          if (newState != state) {
+            setState(newState);
+          }
+        }
+      }
+
+      static uint32_t topBit(uint32_t bits) {
+        uint32_t mask = 0x80000000UL;
+        while (mask != 0 && !(bits & mask)) {
+          mask >>= 1;
+        }
+        return mask;
+      }
+
+      static bool appendBits(uint32_t& bits, byte& length, byte value, byte count) {
+        if (length + count > 32) {
+          #ifdef DEVICE_REACTOR_DEBUG
+            DR_DEBUG_PRINTLN("ERROR: Morse text longer than 32 units");
+          #endif
+          return false;
+        }
+        bits = (bits << count) | value;
+        length += count;
+        return true;
+      }
+
+      void runBlink() {
+        if (blinking) {
+          // Note: (millis() - effectTime) handles millis() rollover correctly
+          if (millis() - effectTime >= effectStep) {
+            effectTime = millis();
+            effectCount++;
+            flip();
+
+            if (effectCount >= effectMax && effectMax > 0) {
+              turnOff();
+              blinking = false;
+            }
+          }
+        }
+      }
+  };
+
+/*****************************************************************************
+ * LED GROUP CLASS
+ *****************************************************************************/
+#if TOTAL_LED_GROUPS > 0
+  // Runs one LED timing engine for several LEDs. The level is computed once
+  // per pass and copied to every member, so members stay phase-locked and
+  // don't run their own blink/pulse timers.
+  class LedGroup {
+    public:
+      void init() {
+        engine.initVirtual();
       }
 
-      // Sprint 2: Zone configuration methods
-      AnalogSensor& addZone(byte id, int min_value, int max_value) {
-        if (zone_count >= MAX_ZONES_PER_SENSOR) {
+      LedGroup& add(LED& led) {
+        if (memberCount >= MAX_LEDS_PER_GROUP) {
           #ifdef DEVICE_REACTOR_DEBUG
-            DR_DEBUG_PRINTLN("ERROR: Maximum zones reached for this sensor");
+            DR_DEBUG_PRINTLN("ERROR: Maximum LEDs reached for this group");
           #endif
           return *this;
         }
+        members[memberCount++] = &led;
+        drive(&led);
+        return *this;
+      }
 
-        // Validate zone boundaries
-        if (min_value > max_value) {
-          #ifdef DEVICE_REACTOR_DEBUG
-            DR_DEBUG_PRINTLN("ERROR: Zone min_value must be <= max_value");
-          #endif
-          return *this;
-        }
+      void turnOn() {
+        stopMembers();
+        engine.turnOn();
+      }
 
-        defined_zones[zone_count].id = id;
-        defined_zones[zone_count].min_val = min_value;
-        defined_zones[zone_count].max_val = max_value;
-        zone_count++;
+      void turnOff() {
+        stopMembers();
+        engine.turnOff();
+      }
 
-        #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINT("Defined zone ID ");
-          DR_DEBUG_PRINT(id);
-          DR_DEBUG_PRINT(" [");
-          DR_DEBUG_PRINT(min_value);
-          DR_DEBUG_PRINT(", ");
-          DR_DEBUG_PRINT(max_value);
-          DR_DEBUG_PRINTLN("]");
-        #endif
+      void flip() {
+        stopMembers();
+        engine.flip();
+      }
 
+      LedGroup& setLevel(byte newLevel) {
+        engine.setLevel(newLevel);
         return *this;
       }
 
-      AnalogSensor& clearZones() {
-        zone_count = 0;
-        currentZoneID = INVALID_HANDLE;
-        previousZoneID = INVALID_HANDLE;
-        #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINTLN("Cleared all zones");
-        #endif
+      LedGroup& blink(unsigned long delay) {
+        stopMembers();
+        engine.blink(delay);
         return *this;
       }
 
-      // Sprint 5: High-level preset configuration
-      AnalogSensor& configure(Preset preset) {
-        // Cast enum to index for array lookup
-        int index = static_cast<int>(preset);
-        const PresetConfig& config = preset_configs[index];
-
-        // Apply common settings
-        smoothing(config.smoothing_samples);
-        outputRange(config.output_min, config.output_max);
+      LedGroup& blink(unsigned long delay, unsigned int count) {
+        stopMembers();
+        engine.blink(delay, count);
+        return *this;
+      }
 
-        // Apply stability mode based on recipe
-        if (config.quantize_step > 0) {
-          // Quantization mode enabled
-          // If H is 0 in table, use auto-calculated default (Q/4)
-          int h = (config.hysteresis_amount > 0)
-                    ? config.hysteresis_amount
-                    : config.quantize_step / 4;
-          quantize(config.quantize_step, h);
-        } else {
-          // Continuous mode with change threshold
-          changeThreshold(config.change_threshold);
-        }
+      LedGroup& pulse(unsigned long pDelay, unsigned int count, byte low, byte high) {
+        stopMembers();
+        engine.pulse(pDelay, count, low, high);
+        return *this;
+      }
 
-        #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINT("Applied preset configuration: ");
-          DR_DEBUG_PRINTLN(index);
-        #endif
+      LedGroup& fadeIn(unsigned long duration) {
+        stopMembers();
+        engine.fadeIn(duration);
+        return *this;
+      }
 
+      LedGroup& fadeIn(unsigned long duration, byte targetLevel) {
+        stopMembers();
+        engine.fadeIn(duration, targetLevel);
         return *this;
       }
 
-      // Sprint 4: Zone change event callback
-      AnalogSensor& onZoneChange(byteParamCallback callback) {
-        hasZoneChangeFunc = true;
-        zoneChanged = callback;
+      LedGroup& fadeOut(unsigned long duration) {
+        stopMembers();
+        engine.fadeOut(duration);
         return *this;
       }
 
-      int value() {
-        // Perform initial read on first call with configured settings
-        if (!hasInitialRead) {
-          performInitialRead();
-        }
-        return currentValue;
+      byte size() {
+        return memberCount;
       }
 
       void update() {
-        // Perform initial read if not done yet (in case update() called before value())
-        if (!hasInitialRead) {
-          performInitialRead();
-          return;  // Don't fire onChange on initial read
+        engine.update();
+
+        // Fan out only when the shared output actually changed
+        if (engine.state != lastState || engine.level != lastLevel) {
+          lastState = engine.state;
+          lastLevel = engine.level;
+          for (byte i = 0; i < memberCount; i++) {
+            drive(members[i]);
+          }
         }
+      }
 
-        // Read raw ADC value
-        int rawValue = analogRead(pin);
+    private:
+      LED engine;
+      LED* members[MAX_LEDS_PER_GROUP];
+      byte memberCount = 0;
+      byte lastState = LOW;
+      byte lastLevel = 255;
+
+      // The group's level is only borrowed for the write, so a member keeps
+      // its own level and on/off or PWM mode for when it is used on its own
+      void drive(LED* led) {
+        byte ownLevel = led->level;
+        bool ownDimmable = led->isDimmable;
+        led->level = engine.level;
+        led->isDimmable = ownDimmable || engine.isDimmable;
+        led->setState(engine.state);
+        led->level = ownLevel;
+        led->isDimmable = ownDimmable;
+      }
 
-        // Apply smoothing
-        if (avgSamples > 1) {
-          average(rawValue);
-        } else {
-          accumulatedSum = rawValue;
-          avgCount = 1;  // Single sample, ready to process
+      // Members follow the group, so their own effects must not fight it
+      void stopMembers() {
+        for (byte i = 0; i < memberCount; i++) {
+          members[i]->clearBlink();
+          members[i]->clearPulse();
         }
+      }
+  };
+#endif
 
-        // Only process when averaging is complete (avgCount == avgSamples)
-        if (avgCount >= avgSamples) {
-          // Calculate the average value from accumulated sum
-          int avgValue = accumulatedSum / avgSamples;
-
-          // Clamp to INPUT range first
-          if (avgValue < inputMin) avgValue = inputMin;
-          if (avgValue > inputMax) avgValue = inputMax;
+/*****************************************************************************
+ * BINDINGS
+ *****************************************************************************/
+#if TOTAL_BINDINGS > 0
+  enum : byte { BIND_NONE, BIND_LEVEL, BIND_TOGGLE, BIND_STATE };
+
+  // One row of Device's binding table, checked every update() after inputs
+  struct Binding {
+    byte kind = BIND_NONE;
+    byte source;              // Button or analog sensor handle
+    byte target;              // LED handle
+    int last = 0;             // Last sensor value, or 1 while the button is held
+    int low = 0;              // Sensor output range start
+    unsigned long scale = 0;  // 255 / output range, 16.16 fixed point
+
+    void connect(byte newKind, byte led, byte ledCount) {
+      if (led >= ledCount) {
+        Serial.println("FATAL ERROR: Invalid LED handle in binding. Halting.");
+        while(1);
+      }
+      target = led;
+      kind = newKind;
+    }
+  };
 
-          // Map from input range to output range
-          hiResValue = map(avgValue, inputMin, inputMax, outputMin, outputMax);
+  // Returned by device.bind(buttonHandle)
+  class ButtonBinding {
+    public:
+      ButtonBinding(Binding& slot, byte ledCount) : slot(slot), ledCount(ledCount) {}
 
-          // Clamp to OUTPUT range
-          if (hiResValue < outputMin) hiResValue = outputMin;
-          if (hiResValue > outputMax) hiResValue = outputMax;
+      void toggle(LedHandle led) {
+        slot.connect(BIND_TOGGLE, led, ledCount);  // Flip on each press
+      }
 
-          // Apply inversion if enabled
-          if (inverted) {
-            hiResValue = outputMax + outputMin - hiResValue;
-          }
+      void toState(LedHandle led) {
+        slot.connect(BIND_STATE, led, ledCount);  // On while held
+      }
 
-          // Sprint 3: Mode selection logic for stability
-          bool valueChanged = false;
-          int newValue = hiResValue;
+    private:
+      Binding& slot;
+      byte ledCount;
+  };
 
-          if (quantizeStep > 0) {
-            // Mode 1: Quantized Hysteresis (Q+H)
-            // Calculate the potential quantized value using proper rounding
-            int V_potential = round((float)hiResValue / quantizeStep) * quantizeStep;
+  // Returned by device.bind(sensorHandle)
+  class SensorBinding {
+    public:
+      SensorBinding(Binding& slot, byte ledCount) : slot(slot), ledCount(ledCount) {}
 
-            // Clamp V_potential to output range
-            if (V_potential < outputMin) V_potential = outputMin;
-            if (V_potential > outputMax) V_potential = outputMax;
+      void toLevel(LedHandle led) {
+        slot.connect(BIND_LEVEL, led, ledCount);  // Output range maps to 0-255
+      }
 
-            // Check if we've crossed a quantization boundary
-            if (V_potential != currentReportedValue) {
-              if (V_potential > currentReportedValue) {
-                // Value is increasing - check upper trigger
-                int trigger_up = (currentReportedValue + quantizeStep / 2) + hysteresis_amount;
-                if (hiResValue >= trigger_up) {
-                  newValue = V_potential;
-                  valueChanged = true;
-                }
-              } else {
-                // Value is decreasing - check lower trigger
-                int trigger_down = (currentReportedValue - quantizeStep / 2) - hysteresis_amount;
-                if (hiResValue <= trigger_down) {
-                  newValue = V_potential;
-                  valueChanged = true;
-                }
-              }
-            }
-          } else if (delta > 1) {
-            // Mode 2: Change Threshold (Floating Anchor)
-            if (abs(hiResValue - currentReportedValue) >= delta) {
-              newValue = hiResValue;
-              valueChanged = true;
-            }
-          } else {
-            // Mode 3: Raw Mode (delta == 1, no quantization)
-            if (hiResValue != currentReportedValue) {
-              newValue = hiResValue;
-              valueChanged = true;
-            }
-          }
+    private:
+      Binding& slot;
+      byte ledCount;
+  };
+#endif
 
-          // Update state and fire onChange if value changed
-          if (valueChanged) {
-            currentReportedValue = newValue;
-            currentValue = newValue;  // Keep currentValue in sync for backward compatibility
-            previousValue = newValue; // Keep previousValue in sync
+/*****************************************************************************
+ * RADIO GROUP CLASS
+ *****************************************************************************/
+#if TOTAL_RADIO_GROUPS > 0
+  // Mutually exclusive options: pressing one option's button selects it and
+  // lights its LED. A change only touches the old and the new LED.
+  class RadioGroup {
+    public:
+      byte handle = INVALID_HANDLE;  // Set by the device, passed to context callbacks
 
-            #ifdef DEVICE_REACTOR_DEBUG
-              DR_DEBUG_PRINT("Analog sensor value changed to ");
-              DR_DEBUG_PRINTLN(currentReportedValue);
-            #endif
+      RadioGroup& onSelect(Delegate<void(byte)> callback) {
+        chosen.set(callback);
+        return *this;
+      }
 
-            if (hasChangeFunc) {
-              changed(currentReportedValue);
-            }
-          }
+      RadioGroup& onSelect(contextByteCallback callback, void* ctx) {
+        chosen.set(callback, ctx);
+        return *this;
+      }
 
-          // Sprint 4: Zone detection and event firing
-          if (zone_count > 0) {
-            // Find which zone the currentReportedValue falls into
-            byte detectedZoneID = findZoneForValue(currentReportedValue);
+      // Select from code (e.g. a restored setting) without calling onSelect;
+      // INVALID_HANDLE selects nothing
+      RadioGroup& select(byte index) {
+        if (index >= count && index != INVALID_HANDLE) {
+          Serial.println("FATAL ERROR: Invalid radio group option. Halting.");
+          while(1);  // Halt execution
+        }
+        show(index);
+        return *this;
+      }
 
-            // Update currentZoneID
-            currentZoneID = detectedZoneID;
+      // Selected option index, INVALID_HANDLE while nothing is selected
+      byte selected() {
+        return current;
+      }
 
-            // Fire onZoneChange if zone changed
-            if (currentZoneID != previousZoneID) {
-              previousZoneID = currentZoneID;
+      byte size() {
+        return count;
+      }
 
-              #ifdef DEVICE_REACTOR_DEBUG
-                DR_DEBUG_PRINT("Zone changed to ");
-                DR_DEBUG_PRINTLN(currentZoneID);
-              #endif
+    private:
+      template <class Cfg> friend class DeviceT;
+
+      Button* buttons[MAX_RADIO_OPTIONS];
+      LED* leds[MAX_RADIO_OPTIONS];  // nullptr for an option without an LED
+      byte count = 0;
+      byte current = INVALID_HANDLE;
+      uint16_t held = 0;  // Bit set = option's button was down last pass
+      CallbackSlot<byte> chosen;
+
+      void add(Button& button, LED* led) {
+        if (count >= MAX_RADIO_OPTIONS) {
+          Serial.println("FATAL ERROR: Too many radio group options. Increase MAX_RADIO_OPTIONS. Halting.");
+          while(1);
+        }
+        buttons[count] = &button;
+        leds[count] = led;
+        // A button already held at setup must be released before it counts
+        if (button.isPressed()) {
+          held |= (uint16_t)1 << count;
+        }
+        if (led != nullptr) {
+          led->turnOff();
+        }
+        count++;
+      }
 
-              if (hasZoneChangeFunc) {
-                zoneChanged(currentZoneID);
+      void update() {
+        for (byte i = 0; i < count; i++) {
+          uint16_t bit = (uint16_t)1 << i;
+          if (!buttons[i]->isPressed()) {
+            held &= ~bit;
+          } else if (!(held & bit)) {
+            held |= bit;
+            if (i != current) {
+              show(i);
+              if (chosen.isSet()) {
+                DR_CALLBACK(DR_SRC_BUTTON_CB, chosen(handle, i));
               }
             }
           }
+        }
+      }
 
-          // Reset accumulator and counter for next cycle
-          accumulatedSum = 0;
-          avgCount = 0;
+      void show(byte index) {
+        if (current != INVALID_HANDLE && leds[current] != nullptr) {
+          leds[current]->turnOff();
+        }
+        current = index;
+        if (current != INVALID_HANDLE && leds[current] != nullptr) {
+          leds[current]->turnOn();
         }
       }
+  };
+#endif
 
-    private:
-      bool initialized = false;
-      bool hasInitialRead = false;
+/*****************************************************************************
+ * HYSTERESIS CONTROLLER CLASS
+ *****************************************************************************/
+#if TOTAL_HYSTERESIS_CONTROLLERS > 0
+  // Thermostat-style on/off output driven by an analog sensor. The output
+  // switches on past one edge of the band and off past the other, and never
+  // sooner than the minimum on/off time after its last switch.
+  class HysteresisController {
+    public:
+      byte handle = INVALID_HANDLE;  // Set by the device, passed to context callbacks
 
-      // Input range (raw ADC values)
-      int inputMin = 0;
-      int inputMax = 1023;
+      // Target in the sensor's output units; the band is centered on it
+      HysteresisController& setpoint(int value) {
+        target = value;
+        return *this;
+      }
 
-      // Output range (mapped values)
-      int outputMin = 0;
-      int outputMax = 1023;
-      bool inverted = false;
-      int quantizeStep = 0;  // 0 = disabled, >0 = snap to grid
+      HysteresisController& band(int width) {
+        bandWidth = width < 0 ? 0 : width;
+        return *this;
+      }
 
-      // Change detection
-      int delta = 1;
-      int currentValue = 0;
-      int previousValue = 0;
+      // Heating (default): on below the band. Cooling: on above it.
+      HysteresisController& cooling(bool enabled = true) {
+        coolingMode = enabled;
+        return *this;
+      }
+
+      // Anti-short-cycle: the output stays on and off for at least this long
+      HysteresisController& minOnTime(unsigned long ms) {
+        minOn = ms;
+        return *this;
+      }
+
+      HysteresisController& minOffTime(unsigned long ms) {
+        minOff = ms;
+        return *this;
+      }
 
-      // Smoothing
-      byte avgSamples = 1;
-      byte avgCount = 0;
-      unsigned long accumulatedSum = 0;  // Use unsigned long to prevent overflow
+      HysteresisController& onActivate(Delegate<void()> callback) {
+        activated.set(callback);
+        return *this;
+      }
 
-      // Callback
-      bool hasChangeFunc = false;
-      intParamCallback changed;
+      HysteresisController& onActivate(contextCallback callback, void* ctx) {
+        activated.set(callback, ctx);
+        return *this;
+      }
 
-      // Sprint 1: New state variables for Quantized Hysteresis and Zones
-      int hiResValue = 0;              // Value after smoothing, clamping, and mapping
-      int currentReportedValue = 0;    // Final stable value exposed to the user
-      int hysteresis_amount = 0;        // The 'H' value for Quantized Hysteresis
+      HysteresisController& onDeactivate(Delegate<void()> callback) {
+        deactivated.set(callback);
+        return *this;
+      }
 
-      // Zone management
-      Zone defined_zones[MAX_ZONES_PER_SENSOR];
-      byte zone_count = 0;
-      byte currentZoneID = INVALID_HANDLE;
-      byte previousZoneID = INVALID_HANDLE;
+      HysteresisController& onDeactivate(contextCallback callback, void* ctx) {
+        deactivated.set(callback, ctx);
+        return *this;
+      }
 
-      // Sprint 4: Zone change callback
-      bool hasZoneChangeFunc = false;
-      byteParamCallback zoneChanged;
+      bool isOn() {
+        return on;
+      }
 
-      void average(int newReading) {
-        accumulatedSum += newReading;
-        avgCount++;
-        // avgCount will be checked in update() to determine if ready to process
+      // Number of times the output switched on
+      unsigned int cycles() {
+        return cycleCount;
       }
 
-      // Sprint 2: Helper method to find zone for a given value
-      byte findZoneForValue(int val) {
-        for (byte i = 0; i < zone_count; i++) {
-          if (val >= defined_zones[i].min_val && val <= defined_zones[i].max_val) {
-            return defined_zones[i].id;
-          }
-        }
-        return INVALID_HANDLE;  // No zone found
+      // Total milliseconds spent on, including the current run
+      unsigned long onTime() {
+        return onTotal + (on ? millis() - lastSwitch : 0);
       }
 
-      void performInitialRead() {
-        // Read raw ADC value with all configured settings applied
-        int rawValue = analogRead(pin);
+      // Number of switches held back by minOnTime()/minOffTime()
+      unsigned int deferred() {
+        return deferredCount;
+      }
 
-        // Pre-fill smoothing buffer with first reading for consistent behavior
-        if (avgSamples > 1) {
-          accumulatedSum = (unsigned long)rawValue * avgSamples;
-          avgCount = avgSamples;
-        } else {
-          accumulatedSum = rawValue;
-          avgCount = 1;
+      void resetStats() {
+        cycleCount = 0;
+        deferredCount = 0;
+        onTotal = 0;
+        if (on) {
+          lastSwitch = millis();
         }
+      }
 
-        // Calculate average (same as update logic)
-        int avgValue = accumulatedSum / avgSamples;
-
-        // Clamp to INPUT range
-        if (avgValue < inputMin) avgValue = inputMin;
-        if (avgValue > inputMax) avgValue = inputMax;
+    private:
+      template <class Cfg> friend class DeviceT;
 
-        // Map from input range to output range
-        hiResValue = map(avgValue, inputMin, inputMax, outputMin, outputMax);
+      AnalogSensor* input = nullptr;
+      byte pin;
+      bool on = false;
+      bool coolingMode = false;
+      bool inverted = false;
+      bool waiting = false;  // A switch is due but held by the minimum time
+      int target = 0;
+      int bandWidth = 0;
+      unsigned long minOn = 0;
+      unsigned long minOff = 0;
+      unsigned long lastSwitch = 0;
+      unsigned long onTotal = 0;
+      unsigned int cycleCount = 0;
+      unsigned int deferredCount = 0;
+      CallbackSlot<> activated;
+      CallbackSlot<> deactivated;
+
+      // The minimum off time also counts from here, so a reset can't
+      // restart a compressor straight away
+      // Polarity is fixed here so the pin is never driven "on" by mistake;
+      // the off level is written before the pin becomes an output
+      void init(AnalogSensor& sensor, byte outputPin, bool activeLow) {
+        input = &sensor;
+        pin = outputPin;
+        inverted = activeLow;
+        write();
+        pinMode(pin, OUTPUT);
+        lastSwitch = millis();
+      }
 
-        // Clamp to OUTPUT range
-        if (hiResValue < outputMin) hiResValue = outputMin;
-        if (hiResValue > outputMax) hiResValue = outputMax;
+      void write() {
+        digitalWrite(pin, (on != inverted) ? HIGH : LOW);
+      }
 
-        // Apply inversion if enabled
-        if (inverted) {
-          hiResValue = outputMax + outputMin - hiResValue;
+      void update(unsigned long now) {
+        if (!input->hasInitialRead) {
+          return;
         }
 
-        // Sprint 3: Initialize currentReportedValue based on mode
-        if (quantizeStep > 0) {
-          // Quantize to nearest grid point using proper rounding
-          currentReportedValue = round((float)hiResValue / quantizeStep) * quantizeStep;
-          // Clamp to output range
-          if (currentReportedValue < outputMin) currentReportedValue = outputMin;
-          if (currentReportedValue > outputMax) currentReportedValue = outputMax;
+        int value = input->currentReportedValue;
+        int low = target - bandWidth / 2;
+        int high = low + bandWidth;
+        bool wanted = on;
+        if (on) {
+          wanted = coolingMode ? (value > low) : (value < high);
         } else {
-          // For Change Threshold or Raw mode, use hiResValue directly
-          currentReportedValue = hiResValue;
+          wanted = coolingMode ? (value >= high) : (value <= low);
         }
-
-        // Keep legacy variables in sync for backward compatibility
-        currentValue = currentReportedValue;
-        previousValue = currentReportedValue;
-
-        // Initialize zone state to prevent onZoneChange firing on first update
-        if (zone_count > 0) {
-          byte initialZone = findZoneForValue(currentReportedValue);
-          currentZoneID = initialZone;
-          previousZoneID = initialZone;
+        if (wanted == on) {
+          waiting = false;
+          return;
         }
 
-        // Reset accumulator for next update cycle
-        accumulatedSum = 0;
-        avgCount = 0;
+        // Note: (now - lastSwitch) handles millis() rollover correctly
+        if ((now - lastSwitch) < (on ? minOn : minOff)) {
+          if (!waiting) {
+            waiting = true;
+            deferredCount++;
+          }
+          return;
+        }
 
-        hasInitialRead = true;
+        waiting = false;
+        on = wanted;
+        write();
+        if (on) {
+          cycleCount++;
+        } else {
+          onTotal += now - lastSwitch;
+        }
+        lastSwitch = now;
 
         #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINT("Initial analog sensor value: ");
-          DR_DEBUG_PRINTLN(currentReportedValue);
+          DR_DEBUG_PRINT("Controller output ");
+          DR_DEBUG_PRINTLN(on);
         #endif
-      }
-  };
-
-  // Sprint 5: Define preset configuration data
-  // This array holds the configuration data for each preset.
-  // The order MUST EXACTLY MATCH the order of the Preset enum.
-  const AnalogSensor::PresetConfig AnalogSensor::preset_configs[] = {
-    // RAW_DATA: No processing, raw 0-1023 values
-    { /*smoothing*/ 1, /*out_min*/ 0, /*out_max*/ 1023, /*Q*/ 0, /*H*/ 0, /*T*/ 1 },
 
-    // POT_FOR_LED: Smooth, continuous 0-255 for analogWrite
-    { /*smoothing*/ 8, /*out_min*/ 0, /*out_max*/ 255,  /*Q*/ 0, /*H*/ 0, /*T*/ 2 },
-
-    // POT_FOR_SERVO: Smooth, continuous 0-180 for servo control
-    { /*smoothing*/ 8, /*out_min*/ 0, /*out_max*/ 180,  /*Q*/ 0, /*H*/ 0, /*T*/ 2 },
-
-    // POT_FOR_PERCENTAGE: Stable 0-100 in steps of 5 (T is irrelevant, Q > 0)
-    { /*smoothing*/ 10, /*out_min*/ 0, /*out_max*/ 100, /*Q*/ 5, /*H*/ 1, /*T*/ 1 },
-
-    // SWITCH_5_POSITION: Heavy 5-position switch with strong hysteresis
-    { /*smoothing*/ 12, /*out_min*/ 0, /*out_max*/ 4,   /*Q*/ 1, /*H*/ 1, /*T*/ 1 }
+        if (on && activated.isSet()) {
+          DR_CALLBACK(DR_SRC_ANALOG_CB, activated(handle));
+        } else if (!on && deactivated.isSet()) {
+          DR_CALLBACK(DR_SRC_ANALOG_CB, deactivated(handle));
+        }
+      }
   };
 #endif
 
 /*****************************************************************************
- * BUTTON CLASS
+ * SEQUENCER CLASS
  *****************************************************************************/
-#if TOTAL_BUTTONS > 0 || TOTAL_ROTARY_ENCODERS > 0
-  class Button {
-    public:
-      byte pin;
-      byte pressMode = BUTTON_INPUT_PULLUP;
+#if TOTAL_SEQUENCERS > 0
+  enum : byte {
+    SEQ_ON,     // Turn the target LED on
+    SEQ_OFF,    // Turn the target LED off
+    SEQ_FLIP,   // Toggle the target LED
+    SEQ_LEVEL,  // Set the target LED to level arg and turn it on
+    SEQ_CALL,   // Run onStep(target, arg)
+    SEQ_WAIT,   // Do nothing but wait
+    SEQ_JUMP,   // Continue at step arg
+    SEQ_END     // Stop here, or start over when looping
+  };
 
-      void init(byte newPin, byte newMode = BUTTON_INPUT_PULLUP) {
-        if (initialized) {
-          Serial.println("WARNING: Button already initialized. Ignoring.");
-          return;
-        }
-        pin = newPin;
-        pressMode = newMode;
+  // One row of a sequence table. Tables live in flash:
+  //   const SeqStep intro[] PROGMEM = { { 0, SEQ_ON, 0, 250 }, ... };
+  struct SeqStep {
+    byte target;     // LED handle (creation order), or an id for SEQ_CALL
+    byte action;     // SEQ_*
+    byte arg;        // Level, jump step, or a value for SEQ_CALL
+    uint16_t delay;  // Milliseconds before the next step runs
+  };
 
-        if (pressMode == BUTTON_INPUT_PULLUP) {
-          pinMode(pin, INPUT_PULLUP);
-        } else {
-          pinMode(pin, INPUT);
-        }
+  // Plays a step table on a single timer. Steps with no delay run in the
+  // same update(), so a sequence only costs one time check while it waits.
+  class Sequencer {
+    public:
+      byte handle = INVALID_HANDLE;  // Set by the device, passed to context callbacks
 
-        // Read the actual pin state to avoid missing first state change
-        state = digitalRead(pin);
-        oldState = state;
-        initialized = true;
+      // Start over from the first step after SEQ_END or the last step
+      Sequencer& loop(bool enabled = true) {
+        looping = enabled;
+        return *this;
+      }
 
-        #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINT("Setup button on pin ");
-          DR_DEBUG_PRINT(pin);
-          DR_DEBUG_PRINT(" initial state: ");
-          DR_DEBUG_PRINTLN(state);
-        #endif
+      Sequencer& onStep(Delegate<void(byte, byte)> callback) {
+        stepped.set(callback);
+        return *this;
       }
 
-      Button& onPress(basicCallback callback) {
-        hasPressFunc = true;
-        pressed = callback;
+      Sequencer& onStep(contextStepCallback callback, void* ctx) {
+        stepped.set(callback, ctx);
         return *this;
       }
 
-      Button& onRelease(basicCallback callback) {
-        hasReleaseFunc = true;
-        released = callback;
+      // Called when a non-looping sequence runs off its end
+      Sequencer& onDone(Delegate<void()> callback) {
+        done.set(callback);
         return *this;
       }
 
-      void update() {
-        checkForPress();
+      Sequencer& onDone(contextCallback callback, void* ctx) {
+        done.set(callback, ctx);
+        return *this;
       }
 
-    protected:
-      bool initialized = false;
-      byte state = HIGH;
-      byte oldState = HIGH;
-      bool hasPressFunc = false;
-      bool hasReleaseFunc = false;
-      basicCallback pressed;
-      basicCallback released;
-      unsigned long lastDebounceTime = 0;
+      void start() {
+        jump(0);
+        running = true;
+        paused = false;
+      }
 
-      void checkForPress() {
-        // Get state
-        state = digitalRead(pin);
+      void stop() {
+        running = false;
+        paused = false;
+      }
 
-        if (state != oldState) {
-          // Note: (millis() - lastDebounceTime) handles millis() rollover correctly
-          if ((millis() - lastDebounceTime) >= DEBOUNCE_DELAY) {
-            oldState = state;
-            lastDebounceTime = millis();
+      void pause() {
+        if (running && !paused) {
+          paused = true;
+          stepStart = millis() - stepStart;  // Holds the elapsed wait while paused
+        }
+      }
 
-            #ifdef DEVICE_REACTOR_DEBUG
-              DR_DEBUG_PRINT("Button state changed to ");
-              DR_DEBUG_PRINTLN(state);
-            #endif
+      void resume() {
+        if (paused) {
+          paused = false;
+          stepStart = millis() - stepStart;
+        }
+      }
 
-            bool isPressed = false;
-            if (pressMode == BUTTON_PRESS_HIGH) {
-              isPressed = (state == HIGH);
-            } else {
-              isPressed = (state == LOW);
-            }
+      // The step runs on the next update(), or straight away from onStep()
+      void jump(byte step) {
+        if (step >= count) {
+          Serial.println("FATAL ERROR: Invalid sequencer step. Halting.");
+          while(1);  // Halt execution
+        }
+        index = step;
+        wait = 0;
+        stepStart = millis();
+      }
+
+      bool isRunning() {
+        return running;
+      }
+
+      bool isPaused() {
+        return paused;
+      }
+
+      // Index of the next step to run
+      byte step() {
+        return index;
+      }
+
+    private:
+      template <class Cfg> friend class DeviceT;
+
+      const SeqStep* steps = nullptr;
+      LED* leds = nullptr;
+      byte count = 0;
+      byte index = 0;
+      bool running = false;
+      bool paused = false;
+      bool looping = false;
+      uint16_t wait = 0;
+      unsigned long stepStart = 0;
+      CallbackSlot<byte, byte> stepped;
+      CallbackSlot<> done;
+
+      // Every target and jump is checked once here so update() doesn't have to
+      void init(const SeqStep* table, byte length, LED* ledArray, byte ledCount) {
+        for (byte i = 0; i < length; i++) {
+          byte action = pgm_read_byte(&table[i].action);
+          if (action <= SEQ_LEVEL && pgm_read_byte(&table[i].target) >= ledCount) {
+            Serial.println("FATAL ERROR: Invalid LED handle in sequence. Halting.");
+            while(1);
+          }
+          if (action == SEQ_JUMP && pgm_read_byte(&table[i].arg) >= length) {
+            Serial.println("FATAL ERROR: Invalid jump in sequence. Halting.");
+            while(1);
+          }
+        }
+        steps = table;
+        count = length;
+        leds = ledArray;
+      }
+
+      void update(unsigned long now) {
+        // Note: (now - stepStart) handles millis() rollover correctly
+        if (!running || paused || (now - stepStart) < wait) {
+          return;
+        }
 
-            if (isPressed && hasPressFunc) {
-              pressed();
-            } else if (!isPressed && hasReleaseFunc) {
-              released();
+        // Bounded so a loop of zero-delay steps can't hold up update()
+        for (unsigned int n = 0; n <= count; n++) {
+          if (index >= count) {
+            if (!looping || count == 0) {
+              running = false;
+              if (done.isSet()) {
+                DR_CALLBACK(DR_SRC_SEQUENCE_CB, done(handle));
+              }
+              return;
             }
-          } else {
-            #ifdef DEVICE_REACTOR_DEBUG
-              DR_DEBUG_PRINTLN("BUTTON DEBOUNCE PROTECTION");
-            #endif
+            index = 0;
+          }
+
+          const SeqStep* current = &steps[index];
+          byte target = pgm_read_byte(&current->target);
+          byte action = pgm_read_byte(&current->action);
+          byte arg = pgm_read_byte(&current->arg);
+          uint16_t delay = pgm_read_word(&current->delay);
+          DR_TRACE_EVENT(DR_EV_FIRE, index);
+          index++;
+          // Set before the callback runs, so pause() and jump() from onStep()
+          // act on this step's delay
+          wait = delay;
+          stepStart = now;
+
+          switch (action) {
+            case SEQ_ON:    leds[target].turnOn();  break;
+            case SEQ_OFF:   leds[target].turnOff(); break;
+            case SEQ_FLIP:  leds[target].flip();    break;
+            case SEQ_LEVEL:
+              leds[target].setLevel(arg);
+              leds[target].turnOn();
+              break;
+            case SEQ_CALL:
+              if (stepped.isSet()) {
+                DR_CALLBACK(DR_SRC_SEQUENCE_CB, stepped(handle, target, arg));
+                if (!running || paused) {
+                  return;
+                }
+              }
+              break;
+            case SEQ_JUMP:  index = arg;            break;
+            case SEQ_END:   index = count;          break;
+          }
+
+          if (wait > 0) {
+            return;
           }
         }
+        wait = 0;
+        stepStart = now;
       }
   };
 #endif
 
 /*****************************************************************************
- * ROTARY ENCODER CLASS
+ * DEVICE CLASS
  *****************************************************************************/
-#if TOTAL_ROTARY_ENCODERS > 0
-  class RotaryEncoder : public Button {
-    public:
-      byte DT, CLK;
+// Capacities of the core component kinds as types, so one sketch can hold
+// several devices of different sizes:
+//   DeviceT<Config<Leds<8>, Buttons<4>, Intervals<16>>> panel;
+// Kinds left out of the Config get no storage at all. Device is the same
+// class with the capacities taken from the TOTAL_* macros.
+template <byte N> struct Leds {};
+template <byte N> struct Buttons {};
+template <byte N> struct AnalogSensors {};
+template <byte N> struct RotaryEncoders {};
+template <byte N> struct Intervals {};
+
+// Capacity of one kind in a Config parameter list, 0 if it is not listed
+template <template <byte> class Kind, typename... Parts>
+struct ConfigCapacity {
+  static const byte value = 0;
+};
 
-      void init(byte swPin, byte dtPin, byte clkPin) {
-        if (initialized) {
-          Serial.println("WARNING: RotaryEncoder already initialized. Ignoring.");
-          return;
+template <template <byte> class Kind, byte N, typename... Rest>
+struct ConfigCapacity<Kind, Kind<N>, Rest...> {
+  static const byte value = N;
+};
+
+template <template <byte> class Kind, typename First, typename... Rest>
+struct ConfigCapacity<Kind, First, Rest...> : ConfigCapacity<Kind, Rest...> {};
+
+template <typename... Parts>
+struct Config {
+  static const byte leds = ConfigCapacity<Leds, Parts...>::value;
+  static const byte buttons = ConfigCapacity<Buttons, Parts...>::value;
+  static const byte analogSensors = ConfigCapacity<AnalogSensors, Parts...>::value;
+  static const byte rotaryEncoders = ConfigCapacity<RotaryEncoders, Parts...>::value;
+  static const byte intervals = ConfigCapacity<Intervals, Parts...>::value;
+};
+
+// One storage base per component kind. The empty N = 0 specializations are
+// what make an unused kind free: empty bases take no space in DeviceT. Both
+// forms answer ledArray()/ledCount() and the like, so code that every device
+// compiles (update(), the accessors) needs no per-kind #if. The arrays are
+// public, as they have always been on Device.
+template <byte N>
+class LedPool {
+  public:
+    LED LEDs[N];
+
+  protected:
+    byte totalSetupLEDs = 0;
+    byte activeLEDs[(N + 7) / 8] = {0};  // Bit set = LED has an effect running
+
+    #ifdef DR_FAST_OUTPUT_ENABLED
+      OutputBatch fastOutputs;
+    #endif
+
+    LED* ledArray() { return LEDs; }
+    byte ledCount() const { return totalSetupLEDs; }
+
+    // Hooks a freshly initialized LED into the active list and returns its handle
+    LedHandle addLED() {
+      LEDs[totalSetupLEDs].activeFlags = &activeLEDs[totalSetupLEDs >> 3];
+      LEDs[totalSetupLEDs].activeMask = 1 << (totalSetupLEDs & 7);
+      LEDs[totalSetupLEDs].handle = totalSetupLEDs;
+      return LedHandle(totalSetupLEDs++);
+    }
+
+    void beginOutputs() {
+      #ifdef DR_FAST_OUTPUT_ENABLED
+        fastOutputs.begin();
+      #endif
+    }
+
+    void updateLEDs() {
+      DR_SECTION_BEGIN(ledsStart, DR_SRC_LEDS);
+      // Only LEDs with a running effect are visited; steady LEDs cost nothing
+      for (byte b = 0; b < sizeof(activeLEDs); b++) {
+        if (activeLEDs[b] == 0) {
+          continue;
         }
-        pin = swPin;
-        DT = dtPin;
-        CLK = clkPin;
+        for (byte bit = 0; bit < 8; bit++) {
+          byte mask = 1 << bit;
+          if (activeLEDs[b] & mask) {
+            DR_SECTION_ITEM((b << 3) + bit);
+            LED& current = LEDs[(b << 3) + bit];
+            current.update();
+            if (!current.isBusy()) {
+              activeLEDs[b] &= ~mask;
+              if (current.done.isSet()) {
+                DR_CALLBACK(DR_SRC_LED_CB, current.done(current.handle));
+              }
+            }
+          }
+        }
+      }
+      DR_SECTION_END(ledsStart, DR_SRC_LEDS);
+    }
 
-        pinMode(pin, INPUT_PULLUP);
-        pinMode(DT, INPUT_PULLUP);
-        pinMode(CLK, INPUT_PULLUP);
+    void flushOutputs() {
+      #ifdef DR_FAST_OUTPUT_ENABLED
+        DR_SECTION_BEGIN(flushStart, DR_SRC_FAST_OUTPUT);
+        fastOutputs.flush();
+        DR_SECTION_END(flushStart, DR_SRC_FAST_OUTPUT);
+      #endif
+    }
+};
 
-        // Initialize button state to match actual pin state
-        state = digitalRead(pin);
-        oldState = state;
+template <>
+class LedPool<0> {
+  protected:
+    LED* ledArray() { return nullptr; }
+    byte ledCount() const { return 0; }
+    void beginOutputs() {}
+    void updateLEDs() {}
+    void flushOutputs() {}
+};
 
-        lastStateCLK = digitalRead(CLK);
-        initialized = true;
+template <byte N>
+class ButtonPool {
+  public:
+    Button buttons[N];
 
-        #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINT("Setup Rotary Encoder SW:");
-          DR_DEBUG_PRINT(pin);
-          DR_DEBUG_PRINT(" DT:");
-          DR_DEBUG_PRINT(DT);
-          DR_DEBUG_PRINT(" CLK:");
-          DR_DEBUG_PRINT(CLK);
-          DR_DEBUG_PRINT(" initial button state: ");
-          DR_DEBUG_PRINTLN(state);
-        #endif
+  protected:
+    byte totalSetupButtons = 0;
+
+    Button* buttonArray() { return buttons; }
+    byte buttonCount() const { return totalSetupButtons; }
+
+    void updateButtons() {
+      DR_SECTION_BEGIN(buttonsStart, DR_SRC_BUTTONS);
+      // Constant bound so small pools can be unrolled
+      for (byte i = 0; i < N; i++) {
+        if (i >= totalSetupButtons) {
+          break;
+        }
+        DR_SECTION_ITEM(i);
+        buttons[i].update();
       }
+      DR_SECTION_END(buttonsStart, DR_SRC_BUTTONS);
+    }
+};
+
+template <>
+class ButtonPool<0> {
+  protected:
+    Button* buttonArray() { return nullptr; }
+    byte buttonCount() const { return 0; }
+    void updateButtons() {}
+};
 
-      RotaryEncoder& onClockwise(basicCallback callback) {
-        hasCWFunc = true;
-        CW = callback;
-        return *this;
-      }
+template <byte N>
+class RotaryEncoderPool {
+  public:
+    RotaryEncoder rotaryEncoders[N];
 
-      RotaryEncoder& onCounterClockwise(basicCallback callback) {
-        hasCCWFunc = true;
-        CCW = callback;
-        return *this;
+  protected:
+    byte totalSetupRotaryEncoders = 0;
+
+    RotaryEncoder* rotaryEncoderArray() { return rotaryEncoders; }
+    byte rotaryEncoderCount() const { return totalSetupRotaryEncoders; }
+
+    void updateRotaryEncoders() {
+      DR_SECTION_BEGIN(encodersStart, DR_SRC_ENCODERS);
+      for (byte i = 0; i < N; i++) {
+        if (i >= totalSetupRotaryEncoders) {
+          break;
+        }
+        DR_SECTION_ITEM(i);
+        rotaryEncoders[i].update();
       }
+      DR_SECTION_END(encodersStart, DR_SRC_ENCODERS);
+    }
+};
 
-      void update() {
-        checkForPress();
+template <>
+class RotaryEncoderPool<0> {
+  protected:
+    RotaryEncoder* rotaryEncoderArray() { return nullptr; }
+    byte rotaryEncoderCount() const { return 0; }
+    void updateRotaryEncoders() {}
+};
 
-        currentStateCLK = digitalRead(CLK);
+template <byte N>
+class AnalogSensorPool {
+  public:
+    AnalogSensor analogSensors[N];
 
-        // If last and current state of CLK are different, then pulse occurred
-        // React to only 1 state change to avoid double count
-        if (currentStateCLK != lastStateCLK && currentStateCLK == 1) {
-          // Apply debouncing to rotation events (shorter delay than button press)
-          // Note: (millis() - lastRotationTime) handles millis() rollover correctly
-          if ((millis() - lastRotationTime) >= ENCODER_DEBOUNCE_DELAY) {
-            lastRotationTime = millis();
+  protected:
+    byte totalSetupAnalogSensors = 0;
+    unsigned long sensorsDueAt = 0;
 
-            // If the DT state is different than the CLK state then
-            // the encoder is rotating CCW
-            if (digitalRead(DT) != currentStateCLK) {
-              if (hasCCWFunc) {
-                CCW();
-              }
-              #ifdef DEVICE_REACTOR_DEBUG
-                DR_DEBUG_PRINTLN("Encoder CCW");
-              #endif
-            } else {  // Encoder is rotating CW
-              if (hasCWFunc) {
-                CW();
-              }
-              #ifdef DEVICE_REACTOR_DEBUG
-                DR_DEBUG_PRINTLN("Encoder CW");
-              #endif
-            }
-          } else {
-            #ifdef DEVICE_REACTOR_DEBUG
-              DR_DEBUG_PRINTLN("ENCODER ROTATION DEBOUNCE PROTECTION");
-            #endif
-          }
-        }
+    AnalogSensor* analogSensorArray() { return analogSensors; }
+    byte analogSensorCount() const { return totalSetupAnalogSensors; }
 
-        // Remember last CLK state
-        lastStateCLK = currentStateCLK;
+    void updateAnalogSensors() {
+      // Skip the whole sensor pass until the earliest sampleInterval() is due
+      // Note: signed difference handles millis() rollover correctly
+      unsigned long now = millis();
+      if ((long)(now - sensorsDueAt) < 0) {
+        return;
       }
+      DR_SECTION_BEGIN(sensorsStart, DR_SRC_ANALOG);
+      unsigned long nextDue = 0xFFFFFFFFUL;
+      for (byte i = 0; i < N; i++) {
+        if (i >= totalSetupAnalogSensors) {
+          break;
+        }
+        if (analogSensors[i].sampleDue(now)) {
+          DR_SECTION_ITEM(i);
+          analogSensors[i].update();
+        }
+        unsigned long wait = analogSensors[i].timeUntilDue(now);
+        if (wait < nextDue) {
+          nextDue = wait;
+        }
+      }
+      sensorsDueAt = now + nextDue;
+      DR_SECTION_END(sensorsStart, DR_SRC_ANALOG);
+    }
+};
 
-    private:
-      byte currentStateCLK;
-      byte lastStateCLK;
-      unsigned long lastRotationTime = 0;
-      bool hasCWFunc = false;
-      bool hasCCWFunc = false;
-      basicCallback CW;
-      basicCallback CCW;
-  };
-#endif
+template <>
+class AnalogSensorPool<0> {
+  protected:
+    AnalogSensor* analogSensorArray() { return nullptr; }
+    byte analogSensorCount() const { return 0; }
+    void updateAnalogSensors() {}
+};
 
-/*****************************************************************************
- * LED CLASS
- *****************************************************************************/
-#if TOTAL_LEDS > 0
-  class LED {
-    public:
-      byte pin, pinG, pinB;
-      byte R = 0, G = 0, B = 0;  // Initialize RGB values to prevent undefined behavior
-      bool isRGB = false;
-      bool isDimmable = false;
-      bool commonAnode = true;
+template <byte N>
+class IntervalPool {
+  public:
+    IntervalSlots<N> intervals;
 
-      // Regular LED initialization
-      void init(byte newPin) {
-        if (initialized) {
-          Serial.println("WARNING: LED already initialized. Ignoring.");
-          return;
-        }
-        pin = newPin;
-        pinMode(pin, OUTPUT);
-        setState(LOW);
-        initialized = true;
+  protected:
+    void updateIntervals() {
+      DR_SECTION_BEGIN(intervalsStart, DR_SRC_INTERVALS);
+      intervals.update();
+      DR_SECTION_END(intervalsStart, DR_SRC_INTERVALS);
+    }
+};
 
-        #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINT("Setup LED on pin ");
-          DR_DEBUG_PRINTLN(pin);
-        #endif
-      }
+template <>
+class IntervalPool<0> {
+  protected:
+    void updateIntervals() {}
+};
 
-      // RGB LED initialization
-      void init(byte newPinR, byte newPinG, byte newPinB) {
-        if (initialized) {
-          Serial.println("WARNING: LED already initialized. Ignoring.");
-          return;
-        }
-        pin = newPinR;
-        pinMode(pin, OUTPUT);
-        pinG = newPinG;
-        pinMode(pinG, OUTPUT);
-        pinB = newPinB;
-        pinMode(pinB, OUTPUT);
-        isRGB = true;
-        setState(LOW);
-        initialized = true;
+// LEDs, buttons, analog sensors, rotary encoders and intervals are sized by
+// Cfg. Everything built on them (groups, strips, bindings, sequencers, ...)
+// is still sized by its TOTAL_* macro and present in every device.
+template <class Cfg>
+class DeviceT : public LedPool<Cfg::leds>,
+                public ButtonPool<Cfg::buttons>,
+                public AnalogSensorPool<Cfg::analogSensors>,
+                public RotaryEncoderPool<Cfg::rotaryEncoders>,
+                public IntervalPool<Cfg::intervals> {
+  public:
+    typedef BasicIntervalHandle<DeviceT> IntervalHandle;
 
-        #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINT("Setup RGB LED on pins ");
-          DR_DEBUG_PRINT(pin);
-          DR_DEBUG_PRINT(",");
-          DR_DEBUG_PRINT(pinG);
-          DR_DEBUG_PRINT(",");
-          DR_DEBUG_PRINTLN(pinB);
-        #endif
+    /****** LEDS *************************************************************/
+    LedHandle newLED(byte pin) {
+      static_assert(Cfg::leds > 0, "No LEDs configured: define TOTAL_LEDS or add Leds<N> to the Config");
+      if (this->totalSetupLEDs >= Cfg::leds) {
+        Serial.println("FATAL ERROR: Too many LEDs. Increase TOTAL_LEDS or Leds<N>. Halting.");
+        while(1);
       }
+      this->LEDs[this->totalSetupLEDs].init(pin);
+      #ifdef DR_FAST_OUTPUT_ENABLED
+        this->LEDs[this->totalSetupLEDs].fastOutputs = &this->fastOutputs;
+      #endif
+      return this->addLED();
+    }
 
-      void turnOn() {
-        setState(HIGH);
+    LedHandle newLED(byte pinR, byte pinG, byte pinB) {
+      static_assert(Cfg::leds > 0, "No LEDs configured: define TOTAL_LEDS or add Leds<N> to the Config");
+      if (this->totalSetupLEDs >= Cfg::leds) {
+        Serial.println("FATAL ERROR: Too many LEDs. Increase TOTAL_LEDS or Leds<N>. Halting.");
+        while(1);
       }
+      this->LEDs[this->totalSetupLEDs].init(pinR, pinG, pinB);
+      return this->addLED();
+    }
 
-      void turnOff() {
-        clearBlink();
-        clearPulse();
-        setState(LOW);
+    LED& led(byte handle) {
+      if (handle >= this->ledCount() || handle == INVALID_HANDLE) {
+        Serial.println("FATAL ERROR: Invalid LED handle. Halting.");
+        while(1);  // Halt execution
       }
+      return this->ledArray()[handle];
+    }
 
-      void flip() {
-        if (state == HIGH) {
-          setState(LOW);
-        } else {
-          setState(HIGH);
+    // Typed handles only come from newLED() and friends, so the range check
+    // is kept in debug builds only (the same holds for the accessors below)
+    LED& led(LedHandle handle) {
+      #ifdef DEVICE_REACTOR_DEBUG
+        return led((byte)handle);
+      #else
+        return this->ledArray()[handle];
+      #endif
+    }
+
+    // A handle of another component type is a compile error
+    template <typename Other>
+    LED& led(ComponentHandle<Other> handle) = delete;
+
+    // Fixed index known at compile time, e.g. device.led<0>(); no runtime check
+    template <byte Index>
+    LED& led() {
+      static_assert(Index < Cfg::leds, "LED index is not below TOTAL_LEDS / Leds<N>");
+      return this->LEDs[Index];
+    }
+
+    /****** LED GROUPS *******************************************************/
+    #if TOTAL_LED_GROUPS > 0
+      LedGroup ledGroups[TOTAL_LED_GROUPS];
+
+      byte newLedGroup() {
+        static_assert(Cfg::leds > 0, "LED groups need LEDs: define TOTAL_LEDS or add Leds<N> to the Config");
+        if (totalSetupLedGroups >= TOTAL_LED_GROUPS) {
+          Serial.println("FATAL ERROR: Too many LED groups. Increase TOTAL_LED_GROUPS. Halting.");
+          while(1);
         }
+        ledGroups[totalSetupLedGroups].init();
+        return totalSetupLedGroups++;
       }
 
-      LED& setLevel(byte newLevel) {
-        isDimmable = true;
-        level = newLevel;
+      byte newLedGroup(const byte* ledHandles, byte count) {
+        byte handle = newLedGroup();
+        for (byte i = 0; i < count; i++) {
+          ledGroups[handle].add(led(ledHandles[i]));
+        }
+        return handle;
+      }
 
-        // If the LED is already on, update the brightness
-        if (state == HIGH) {
-          setState(HIGH);
+      LedGroup& ledGroup(byte handle) {
+        if (handle >= totalSetupLedGroups || handle == INVALID_HANDLE) {
+          Serial.println("FATAL ERROR: Invalid LED group handle. Halting.");
+          while(1);  // Halt execution
         }
+        return ledGroups[handle];
+      }
+    #endif
 
-        #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINT("LED level: ");
-          DR_DEBUG_PRINTLN(level);
-        #endif
+    /****** BUTTONS **********************************************************/
+    ButtonHandle newButton(byte pin, byte mode = BUTTON_INPUT_PULLUP) {
+      static_assert(Cfg::buttons > 0, "No buttons configured: define TOTAL_BUTTONS or add Buttons<N> to the Config");
+      if (this->totalSetupButtons >= Cfg::buttons) {
+        Serial.println("FATAL ERROR: Too many buttons. Increase TOTAL_BUTTONS or Buttons<N>. Halting.");
+        while(1);
+      }
+      Button& button = this->buttons[this->totalSetupButtons];
+      button.init(pin, mode);
+      button.handle = this->totalSetupButtons;
+      #if TOTAL_SUBSCRIBERS > 0
+        button.bus = &eventBus;
+      #endif
+      return ButtonHandle(this->totalSetupButtons++);
+    }
 
-        return *this;
+    Button& button(byte handle) {
+      if (handle >= this->buttonCount() || handle == INVALID_HANDLE) {
+        Serial.println("FATAL ERROR: Invalid button handle. Halting.");
+        while(1);  // Halt execution
       }
+      return this->buttonArray()[handle];
+    }
 
-      LED& setColor(byte newR, byte newG, byte newB) {
-        // Store raw RGB values
-        byte rawR = newR;
-        byte rawG = newG;
-        byte rawB = newB;
-
-        // Apply common anode inversion if needed
-        if (commonAnode) {
-          R = 255 - rawR;
-          G = 255 - rawG;
-          B = 255 - rawB;
-        } else {
-          R = rawR;
-          G = rawG;
-          B = rawB;
-        }
+    Button& button(ButtonHandle handle) {
+      #ifdef DEVICE_REACTOR_DEBUG
+        return button((byte)handle);
+      #else
+        return this->buttonArray()[handle];
+      #endif
+    }
 
-        #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINT("RGB Color: ");
-          DR_DEBUG_PRINT(rawR);
-          DR_DEBUG_PRINT(",");
-          DR_DEBUG_PRINT(rawG);
-          DR_DEBUG_PRINT(",");
-          DR_DEBUG_PRINTLN(rawB);
-        #endif
+    template <typename Other>
+    Button& button(ComponentHandle<Other> handle) = delete;
 
-        // Only update the hardware if the LED is already on
-        if (state == HIGH) {
-          setState(HIGH);
-        }
+    template <byte Index>
+    Button& button() {
+      static_assert(Index < Cfg::buttons, "Button index is not below TOTAL_BUTTONS / Buttons<N>");
+      return this->buttons[Index];
+    }
 
-        return *this;
+    /****** ANALOG SENSORS ***************************************************/
+    AnalogSensorHandle newAnalogSensor(byte pin) {
+      static_assert(Cfg::analogSensors > 0, "No analog sensors configured: define TOTAL_ANALOG_SENSORS or add AnalogSensors<N> to the Config");
+      if (this->totalSetupAnalogSensors >= Cfg::analogSensors) {
+        Serial.println("FATAL ERROR: Too many analog sensors. Increase TOTAL_ANALOG_SENSORS or AnalogSensors<N>. Halting.");
+        while(1);
       }
+      AnalogSensor& sensor = this->analogSensors[this->totalSetupAnalogSensors];
+      sensor.init(pin);
+      sensor.handle = this->totalSetupAnalogSensors;
+      sensor.dueAt = &this->sensorsDueAt;
+      #if TOTAL_SUBSCRIBERS > 0
+        sensor.bus = &eventBus;
+      #endif
+      this->sensorsDueAt = millis();
+      return AnalogSensorHandle(this->totalSetupAnalogSensors++);
+    }
 
-      LED& setCommonAnode(bool isCommonAnode) {
-        commonAnode = isCommonAnode;
-        return *this;
+    AnalogSensor& analogSensor(byte handle) {
+      if (handle >= this->analogSensorCount() || handle == INVALID_HANDLE) {
+        Serial.println("FATAL ERROR: Invalid analog sensor handle. Halting.");
+        while(1);  // Halt execution
       }
+      return this->analogSensorArray()[handle];
+    }
 
-      LED& pulse(unsigned long pDelay, unsigned int count, byte low, byte high) {
-        initPulse(pDelay, count, low, high);
-        return *this;
-      }
+    AnalogSensor& analogSensor(AnalogSensorHandle handle) {
+      #ifdef DEVICE_REACTOR_DEBUG
+        return analogSensor((byte)handle);
+      #else
+        return this->analogSensorArray()[handle];
+      #endif
+    }
 
-      LED& fadeIn(unsigned long duration) {
-        return fadeIn(duration, 255);
+    template <typename Other>
+    AnalogSensor& analogSensor(ComponentHandle<Other> handle) = delete;
+
+    template <byte Index>
+    AnalogSensor& analogSensor() {
+      static_assert(Index < Cfg::analogSensors, "AnalogSensor index is not below TOTAL_ANALOG_SENSORS / AnalogSensors<N>");
+      return this->analogSensors[Index];
+    }
+
+    /****** ROTARY ENCODERS **************************************************/
+    RotaryEncoderHandle newRotaryEncoder(byte swPin, byte dtPin, byte clkPin) {
+      static_assert(Cfg::rotaryEncoders > 0, "No rotary encoders configured: define TOTAL_ROTARY_ENCODERS or add RotaryEncoders<N> to the Config");
+      if (this->totalSetupRotaryEncoders >= Cfg::rotaryEncoders) {
+        Serial.println("FATAL ERROR: Too many rotary encoders. Increase TOTAL_ROTARY_ENCODERS or RotaryEncoders<N>. Halting.");
+        while(1);
       }
+      RotaryEncoder& encoder = this->rotaryEncoders[this->totalSetupRotaryEncoders];
+      encoder.init(swPin, dtPin, clkPin);
+      encoder.handle = this->totalSetupRotaryEncoders;
+      #if TOTAL_SUBSCRIBERS > 0
+        encoder.bus = &eventBus;
+      #endif
+      return RotaryEncoderHandle(this->totalSetupRotaryEncoders++);
+    }
 
-      LED& fadeIn(unsigned long duration, byte targetLevel) {
-        // Fade from 0 to targetLevel over duration ms (one-shot fade)
-        initFade(duration, 0, targetLevel);
-        return *this;
+    RotaryEncoder& rotaryEncoder(byte handle) {
+      if (handle >= this->rotaryEncoderCount() || handle == INVALID_HANDLE) {
+        Serial.println("FATAL ERROR: Invalid rotary encoder handle. Halting.");
+        while(1);  // Halt execution
       }
+      return this->rotaryEncoderArray()[handle];
+    }
 
-      LED& fadeOut(unsigned long duration) {
-        // Only fade out if LED is actually on, otherwise do nothing
-        if (state == LOW) {
-          return *this;  // Already off, no fade needed
-        }
+    RotaryEncoder& rotaryEncoder(RotaryEncoderHandle handle) {
+      #ifdef DEVICE_REACTOR_DEBUG
+        return rotaryEncoder((byte)handle);
+      #else
+        return this->rotaryEncoderArray()[handle];
+      #endif
+    }
 
-        // Fade from current level to 0 over duration ms
-        // Determine start level: use current level if dimmable, otherwise 255
-        byte startLevel = (isDimmable && level > 0) ? level : 255;
+    template <typename Other>
+    RotaryEncoder& rotaryEncoder(ComponentHandle<Other> handle) = delete;
 
-        initFade(duration, startLevel, 0);
-        return *this;
+    template <byte Index>
+    RotaryEncoder& rotaryEncoder() {
+      static_assert(Index < Cfg::rotaryEncoders, "RotaryEncoder index is not below TOTAL_ROTARY_ENCODERS / RotaryEncoders<N>");
+      return this->rotaryEncoders[Index];
+    }
+
+    /****** BINDINGS *******************************************************/
+    #if TOTAL_BINDINGS > 0
+      // Input-to-LED wiring run by update() itself, with no user callback:
+      //   device.bind(button).toggle(led);  device.bind(sensor).toLevel(led);
+      ButtonBinding bind(ButtonHandle handle) {
+        static_assert(Cfg::leds > 0, "Bindings need LEDs: define TOTAL_LEDS or add Leds<N> to the Config");
+        button((byte)handle);  // Validates the handle
+        return ButtonBinding(newBinding(handle), this->ledCount());
       }
 
-      LED& blink(unsigned long delay) {
-        initBlink(delay, 0);
-        return *this;
+      // Scaling is taken from the sensor now, so configure its outputRange() first
+      SensorBinding bind(AnalogSensorHandle handle) {
+        static_assert(Cfg::leds > 0, "Bindings need LEDs: define TOTAL_LEDS or add Leds<N> to the Config");
+        AnalogSensor& sensor = analogSensor((byte)handle);
+        Binding& slot = newBinding(handle);
+        long range = (long)sensor.outputMax - sensor.outputMin;
+        slot.low = sensor.outputMin;
+        slot.scale = (range > 0) ? ((255UL << 16) + range - 1) / range : 0;  // Rounded up so outputMax gives 255
+        slot.last = sensor.outputMin - 1;  // Never a reported value, so the first one applies
+        return SensorBinding(slot, this->ledCount());
       }
+    #endif
 
-      LED& blink(unsigned long delay, unsigned int count) {
-        initBlink(delay, count);
-        return *this;
+    /****** HYSTERESIS CONTROLLERS *****************************************/
+    #if TOTAL_HYSTERESIS_CONTROLLERS > 0
+      HysteresisController hysteresisControllers[TOTAL_HYSTERESIS_CONTROLLERS];
+
+      // Drives outputPin from the sensor's reported value; no interval slots used.
+      // activeLow is for relay boards that switch on with a LOW input.
+      HysteresisControllerHandle newHysteresisController(AnalogSensorHandle sensor, byte outputPin, bool activeLow = false) {
+        static_assert(Cfg::analogSensors > 0, "Hysteresis controllers need analog sensors: define TOTAL_ANALOG_SENSORS or add AnalogSensors<N> to the Config");
+        if (totalSetupHysteresisControllers >= TOTAL_HYSTERESIS_CONTROLLERS) {
+          Serial.println("FATAL ERROR: Too many hysteresis controllers. Increase TOTAL_HYSTERESIS_CONTROLLERS. Halting.");
+          while(1);
+        }
+        HysteresisController& controller = hysteresisControllers[totalSetupHysteresisControllers];
+        controller.init(analogSensor((byte)sensor), outputPin, activeLow);
+        controller.handle = totalSetupHysteresisControllers;
+        return HysteresisControllerHandle(totalSetupHysteresisControllers++);
       }
 
-      void update() {
-        runBlink();
-        runPulse();
+      HysteresisController& hysteresisController(byte handle) {
+        if (handle >= totalSetupHysteresisControllers || handle == INVALID_HANDLE) {
+          Serial.println("FATAL ERROR: Invalid hysteresis controller handle. Halting.");
+          while(1);  // Halt execution
+        }
+        return hysteresisControllers[handle];
       }
 
-    private:
-      bool initialized = false;
-      byte state = LOW;
-      byte level = 255;  // Default to full brightness for intuitive turnOn() behavior
-      unsigned int blinkCount = 0;
-      unsigned int blinkMax = 0;
-      unsigned long lastBlinkTime = 0;
-      unsigned long blinkDelay = 0;
-      bool blinking = false;
+      HysteresisController& hysteresisController(HysteresisControllerHandle handle) {
+        #ifdef DEVICE_REACTOR_DEBUG
+          return hysteresisController((byte)handle);
+        #else
+          return hysteresisControllers[handle];
+        #endif
+      }
 
-      unsigned int pulseCount = 0;
-      unsigned int pulseMax = 0;
-      byte pulseLow = 0;
-      byte pulseHigh = 255;
-      unsigned long pulseDuration = 0;  // Half-period duration in ms
-      bool pulseUp = true;
-      unsigned long lastPulseTime = 0;
-      bool pulsing = false;
+      template <typename Other>
+      HysteresisController& hysteresisController(ComponentHandle<Other> handle) = delete;
+    #endif
 
-      void setState(byte newState) {
-        state = newState;
+    /****** RADIO GROUPS ***************************************************/
+    #if TOTAL_RADIO_GROUPS > 0
+      RadioGroup radioGroups[TOTAL_RADIO_GROUPS];
 
-        if (isRGB) {
-          if (state == LOW) {
-            byte val = 0;
-            if (commonAnode) {
-              val = 255;
-            }
-            analogWrite(pin, val);
-            analogWrite(pinG, val);
-            analogWrite(pinB, val);
-          } else {
-            analogWrite(pin, R);
-            analogWrite(pinG, G);
-            analogWrite(pinB, B);
-          }
-        } else if (isDimmable) {
-          analogWrite(pin, (state == HIGH) ? level : LOW);
-        } else {
-          digitalWrite(pin, state);
+      // Option i is buttonHandles[i] with indicator ledHandles[i]. ledHandles
+      // may be nullptr, or hold LedHandle() for options without an LED.
+      RadioGroupHandle newRadioGroup(const ButtonHandle* buttonHandles, const LedHandle* ledHandles, byte count) {
+        static_assert(Cfg::buttons > 0, "Radio groups need buttons: define TOTAL_BUTTONS or add Buttons<N> to the Config");
+        if (totalSetupRadioGroups >= TOTAL_RADIO_GROUPS) {
+          Serial.println("FATAL ERROR: Too many radio groups. Increase TOTAL_RADIO_GROUPS. Halting.");
+          while(1);
         }
+        RadioGroup& group = radioGroups[totalSetupRadioGroups];
+        group.handle = totalSetupRadioGroups;
+        for (byte i = 0; i < count; i++) {
+          LED* indicator = nullptr;
+          if (ledHandles != nullptr && (byte)ledHandles[i] != INVALID_HANDLE) {
+            indicator = &led((byte)ledHandles[i]);  // Validates the handle
+          }
+          group.add(button((byte)buttonHandles[i]), indicator);
+        }
+        return RadioGroupHandle(totalSetupRadioGroups++);
       }
 
-      void initPulse(unsigned long pDelay, unsigned int count, byte low, byte high) {
+      RadioGroup& radioGroup(byte handle) {
+        if (handle >= totalSetupRadioGroups || handle == INVALID_HANDLE) {
+          Serial.println("FATAL ERROR: Invalid radio group handle. Halting.");
+          while(1);  // Halt execution
+        }
+        return radioGroups[handle];
+      }
+
+      RadioGroup& radioGroup(RadioGroupHandle handle) {
         #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINTLN("Initiate Pulse");
+          return radioGroup((byte)handle);
+        #else
+          return radioGroups[handle];
         #endif
+      }
 
-        clearBlink();
-        clearPulse();
+      template <typename Other>
+      RadioGroup& radioGroup(ComponentHandle<Other> handle) = delete;
+    #endif
 
-        pulseLow = low;
-        pulseHigh = high;
-        pulseMax = count;
-        // Guard against zero delay to prevent excessive updates
-        unsigned long safePDelay = (pDelay < 2) ? 2 : pDelay;
-        pulseDuration = safePDelay / 2;  // Half-period (time to go from low to high or vice versa)
-        lastPulseTime = millis();
-        pulsing = true;
+    /****** SEQUENCERS *****************************************************/
+    #if TOTAL_SEQUENCERS > 0
+      Sequencer sequencers[TOTAL_SEQUENCERS];
 
-        setLevel(pulseLow);
-        setState(HIGH);
+      // steps must point to a PROGMEM table; create its LEDs first
+      SequencerHandle newSequencer(const SeqStep* steps, byte count) {
+        if (totalSetupSequencers >= TOTAL_SEQUENCERS) {
+          Serial.println("FATAL ERROR: Too many sequencers. Increase TOTAL_SEQUENCERS. Halting.");
+          while(1);
+        }
+        sequencers[totalSetupSequencers].init(steps, count, this->ledArray(), this->ledCount());
+        sequencers[totalSetupSequencers].handle = totalSetupSequencers;
+        return SequencerHandle(totalSetupSequencers++);
       }
 
-      void initFade(unsigned long duration, byte start, byte end) {
+      Sequencer& sequencer(byte handle) {
+        if (handle >= totalSetupSequencers || handle == INVALID_HANDLE) {
+          Serial.println("FATAL ERROR: Invalid sequencer handle. Halting.");
+          while(1);  // Halt execution
+        }
+        return sequencers[handle];
+      }
+
+      Sequencer& sequencer(SequencerHandle handle) {
         #ifdef DEVICE_REACTOR_DEBUG
-          DR_DEBUG_PRINTLN("Initiate Fade");
+          return sequencer((byte)handle);
+        #else
+          return sequencers[handle];
         #endif
+      }
 
-        clearBlink();
-        clearPulse();
+      template <typename Other>
+      Sequencer& sequencer(ComponentHandle<Other> handle) = delete;
+    #endif
 
-        pulseLow = start;
-        pulseHigh = end;
-        pulseMax = 0;  // Signifies a one-way fade
-        // Guard against zero duration to prevent division issues and excessive updates
-        pulseDuration = (duration < 1) ? 1 : duration;  // Use full duration (not halved like pulse)
-        lastPulseTime = millis();
-        pulsing = true;
-        pulseUp = (end > start);  // Determine direction
+    /****** EVENT BUS ******************************************************/
+    #if TOTAL_SUBSCRIBERS > 0
+      // Register in setup(); handlers run in subscription order for a topic
+      void subscribe(byte topic, BusHandler handler) {
+        eventBus.subscribe(topic, handler);
+      }
 
-        setLevel(start);
-        setState(HIGH);
+      // Sketch-level publish; subscribers see handle == INVALID_HANDLE
+      void publish(byte topic, byte event = DR_EV_USER, int value = 0) {
+        eventBus.publish(topic, event, INVALID_HANDLE, value);
       }
+    #endif
 
-      void clearPulse() {
-        pulseCount = 0;
-        pulseMax = 0;
-        pulseLow = 0;
-        pulseHigh = 0;
-        pulseDuration = 0;
-        pulseUp = true;
-        pulsing = false;
+    /****** PIXEL STRIPS *****************************************************/
+    #if TOTAL_PIXEL_STRIPS > 0
+      PixelStrip pixelStrips[TOTAL_PIXEL_STRIPS];
+
+      // WS2812 (one data pin) or PIXEL_CAPTURE (pin unused)
+      byte newPixelStrip(byte type, byte dataPin, unsigned int count) {
+        return newPixelStrip(type, dataPin, INVALID_HANDLE, count);
       }
 
-      void runPulse() {
-        if (pulsing) {
-          unsigned long elapsed = millis() - lastPulseTime;
-          byte desiredLevel;
-
-          if (pulseUp) {
-            // Calculate level using integer math: low + (range * elapsed / duration)
-            if (elapsed >= pulseDuration) {
-              // Reached the high point
-              level = pulseHigh;
-              setState(HIGH);
-              if (pulseMax == 0) {
-                // One-way fade (fadeIn), stop here
-                clearPulse();
-                return;
-              }
-              pulseUp = false;
-              lastPulseTime = millis();
-            } else {
-              // Map elapsed time to level using integer math
-              // Cast to unsigned long BEFORE multiplication to prevent overflow
-              unsigned int range = pulseHigh - pulseLow;
-              desiredLevel = pulseLow + ((unsigned long)range * elapsed) / pulseDuration;
-              if (level != desiredLevel) {
-                level = desiredLevel;
-                setState(HIGH);
-              }
-            }
-          } else {
-            // Fading down
-            if (elapsed >= pulseDuration) {
-              // Reached the low point
-              if (pulseMax == 0) {
-                // One-way fade (fadeOut), stop here
-                level = pulseLow;
-                setState(HIGH);
-                clearPulse();
-                setState(LOW);  // Turn off at end of fadeOut
-                return;
-              }
-              lastPulseTime = millis();
-              pulseUp = true;
-              pulseCount++;
-            } else {
-              // Map elapsed time to level (going down) using integer math
-              // Cast to unsigned long BEFORE multiplication to prevent overflow
-              unsigned int range = pulseHigh - pulseLow;
-              desiredLevel = pulseHigh - ((unsigned long)range * elapsed) / pulseDuration;
-              if (level != desiredLevel) {
-                level = desiredLevel;
-                setState(HIGH);
-              }
-            }
+      // APA102 (data + clock; both ignored when DEVICE_REACTOR_USE_SPI is set)
+      byte newPixelStrip(byte type, byte dataPin, byte clockPin, unsigned int count) {
+        if (totalSetupPixelStrips >= TOTAL_PIXEL_STRIPS) {
+          Serial.println("FATAL ERROR: Too many pixel strips. Increase TOTAL_PIXEL_STRIPS. Halting.");
+          while(1);
+        }
+        #if !(defined(__AVR__) && (F_CPU == 16000000L))
+          // sendWS2812() is timed in AVR cycles and compiles to nothing elsewhere
+          if (type == PIXEL_WS2812) {
+            Serial.println("FATAL ERROR: WS2812 output needs AVR @ 16MHz. Use PIXEL_APA102 or PIXEL_CAPTURE. Halting.");
+            while(1);
           }
+        #endif
+        pixelStrips[totalSetupPixelStrips].handle = totalSetupPixelStrips;
+        pixelStrips[totalSetupPixelStrips].init(type, dataPin, clockPin, count);
+        return totalSetupPixelStrips++;
+      }
 
-          // We've pulsed enough
-          if (pulseCount >= pulseMax && pulseMax > 0) {
-            clearPulse();
-            setState(LOW);
-          }
+      PixelStrip& pixelStrip(byte handle) {
+        if (handle >= totalSetupPixelStrips || handle == INVALID_HANDLE) {
+          Serial.println("FATAL ERROR: Invalid pixel strip handle. Halting.");
+          while(1);  // Halt execution
         }
+        return pixelStrips[handle];
       }
 
-      void initBlink(unsigned long bDelay, unsigned int count) {
-        clearPulse();
-        blinkCount = 0;
-        // For finite blinks: ensure LED ends OFF after count blinks
-        // If currently OFF, need count*2 flips. If currently ON, need count*2-1 flips to end OFF
-        if (count > 0) {
-          blinkMax = (state == HIGH) ? (count * 2 - 1) : (count * 2);
-        } else {
-          blinkMax = 0;  // Infinite blink
+      // Returns an LED handle bound to one pixel, so device.led() effects apply to it
+      LedHandle newPixelLED(byte stripHandle, unsigned int pixel) {
+        static_assert(Cfg::leds > 0, "Pixel LEDs need LED slots: define TOTAL_LEDS or add Leds<N> to the Config");
+        if (this->totalSetupLEDs >= Cfg::leds) {
+          Serial.println("FATAL ERROR: Too many LEDs. Increase TOTAL_LEDS or Leds<N>. Halting.");
+          while(1);
         }
-        // Guard against zero delay to prevent excessive toggling
-        unsigned long safeBDelay = (bDelay < 1) ? 1 : bDelay;
-        blinkDelay = safeBDelay / 2;  // Since we need to flip
-        lastBlinkTime = millis();  // Wait for first interval before starting
-        blinking = true;
+        this->LEDs[this->totalSetupLEDs].init(&pixelStrip(stripHandle), pixel);
+        return this->addLED();
       }
+    #endif
 
-      void clearBlink() {
-        blinkCount = 0;
-        blinkMax = 0;
-        lastBlinkTime = 0;
-        blinkDelay = 0;
-        blinking = false;
-      }
+    /****** SHIFT REGISTERS **************************************************/
+    #if TOTAL_SHIFT_REGISTERS > 0
+      ShiftRegisterBank shiftRegisters;
 
-      void runBlink() {
-        if (blinking) {
-          // Note: (millis() - lastBlinkTime) handles millis() rollover correctly
-          if (millis() - lastBlinkTime >= blinkDelay) {
-            lastBlinkTime = millis();
-            blinkCount++;
-            flip();
+      // Pins are ignored for data/clock when DEVICE_REACTOR_USE_SPI is set
+      void setupShiftRegisters(byte dataPin, byte clockPin, byte latchPin) {
+        shiftRegisters.init(dataPin, clockPin, latchPin);
+      }
 
-            if (blinkCount >= blinkMax && blinkMax > 0) {
-              turnOff();
-              blinking = false;
-            }
-          }
+      // Returns an LED handle bound to one bank output (0 = first chip, Q0)
+      LedHandle newShiftLED(byte bit) {
+        static_assert(Cfg::leds > 0, "Shift register LEDs need LED slots: define TOTAL_LEDS or add Leds<N> to the Config");
+        if (this->totalSetupLEDs >= Cfg::leds) {
+          Serial.println("FATAL ERROR: Too many LEDs. Increase TOTAL_LEDS or Leds<N>. Halting.");
+          while(1);
         }
+        if (bit >= TOTAL_SHIFT_REGISTERS * 8) {
+          Serial.println("FATAL ERROR: Shift register bit out of range. Increase TOTAL_SHIFT_REGISTERS. Halting.");
+          while(1);
+        }
+        this->LEDs[this->totalSetupLEDs].init(&shiftRegisters, bit);
+        return this->addLED();
       }
-  };
-#endif
+    #endif
 
-/*****************************************************************************
- * DEVICE CLASS
- *****************************************************************************/
-class Device {
-  public:
-    /****** LEDS *************************************************************/
-    #if TOTAL_LEDS > 0
-      LED LEDs[TOTAL_LEDS];
+    /****** CHARLIEPLEXED ARRAYS *********************************************/
+    #if TOTAL_CHARLIE_ARRAYS > 0
+      CharlieArray charlieArrays[TOTAL_CHARLIE_ARRAYS];
 
-      byte newLED(byte pin) {
-        if (totalSetupLEDs >= TOTAL_LEDS) {
-          Serial.println("FATAL ERROR: Too many LEDs. Increase TOTAL_LEDS. Halting.");
+      byte newCharlieArray(const byte* pins, byte count) {
+        if (totalSetupCharlieArrays >= TOTAL_CHARLIE_ARRAYS) {
+          Serial.println("FATAL ERROR: Too many charlieplexed arrays. Increase TOTAL_CHARLIE_ARRAYS. Halting.");
           while(1);
         }
-        LEDs[totalSetupLEDs].init(pin);
-        return totalSetupLEDs++;
+        charlieArrays[totalSetupCharlieArrays].init(pins, count);
+        return totalSetupCharlieArrays++;
       }
 
-      byte newLED(byte pinR, byte pinG, byte pinB) {
-        if (totalSetupLEDs >= TOTAL_LEDS) {
-          Serial.println("FATAL ERROR: Too many LEDs. Increase TOTAL_LEDS. Halting.");
-          while(1);
+      CharlieArray& charlieArray(byte handle) {
+        if (handle >= totalSetupCharlieArrays || handle == INVALID_HANDLE) {
+          Serial.println("FATAL ERROR: Invalid charlieplexed array handle. Halting.");
+          while(1);  // Halt execution
         }
-        LEDs[totalSetupLEDs].init(pinR, pinG, pinB);
-        return totalSetupLEDs++;
+        return charlieArrays[handle];
       }
 
-      LED& led(byte handle) {
-        if (handle >= totalSetupLEDs || handle == INVALID_HANDLE) {
-          Serial.println("FATAL ERROR: Invalid LED handle. Halting.");
-          while(1);  // Halt execution
+      // Returns an LED handle for one LED of the array, usable with device.led()
+      LedHandle newCharlieLED(byte arrayHandle, byte index) {
+        static_assert(Cfg::leds > 0, "Charlieplexed LEDs need LED slots: define TOTAL_LEDS or add Leds<N> to the Config");
+        if (this->totalSetupLEDs >= Cfg::leds) {
+          Serial.println("FATAL ERROR: Too many LEDs. Increase TOTAL_LEDS or Leds<N>. Halting.");
+          while(1);
         }
-        return LEDs[handle];
+        this->LEDs[this->totalSetupLEDs].init(&charlieArray(arrayHandle), index);
+        return this->addLED();
       }
     #endif
 
-    /****** BUTTONS **********************************************************/
-    #if TOTAL_BUTTONS > 0
-      Button buttons[TOTAL_BUTTONS];
+    /****** INTERVALS ********************************************************/
+    IntervalHandle after(unsigned long delayMs, Delegate<void(byte)> callback) {
+      static_assert(Cfg::intervals > 0, "No intervals configured: define TOTAL_INTERVALS or add Intervals<N> to the Config");
+      byte idx = this->intervals.add(callback, delayMs, 1, 0);  // Run once
+      return IntervalHandle(this, idx);
+    }
 
-      byte newButton(byte pin, byte mode = BUTTON_INPUT_PULLUP) {
-        if (totalSetupButtons >= TOTAL_BUTTONS) {
-          Serial.println("FATAL ERROR: Too many buttons. Increase TOTAL_BUTTONS. Halting.");
-          while(1);
+    IntervalHandle every(unsigned long delayMs, Delegate<void(byte)> callback) {
+      static_assert(Cfg::intervals > 0, "No intervals configured: define TOTAL_INTERVALS or add Intervals<N> to the Config");
+      byte idx = this->intervals.add(callback, delayMs, 0, 0);  // Run forever
+      return IntervalHandle(this, idx);
+    }
+
+    IntervalHandle repeat(unsigned long delayMs, unsigned int count, Delegate<void(byte)> callback) {
+      static_assert(Cfg::intervals > 0, "No intervals configured: define TOTAL_INTERVALS or add Intervals<N> to the Config");
+      byte idx = this->intervals.add(callback, delayMs, count, 0);  // Run count times
+      return IntervalHandle(this, idx);
+    }
+
+    // Context forms: the callback gets the interval's slot, message and ctx
+    IntervalHandle after(unsigned long delayMs, contextByteCallback callback, void* ctx) {
+      static_assert(Cfg::intervals > 0, "No intervals configured: define TOTAL_INTERVALS or add Intervals<N> to the Config");
+      byte idx = this->intervals.add(CallbackSlot<byte>(callback, ctx), delayMs, 1, 0);
+      return IntervalHandle(this, idx);
+    }
+
+    IntervalHandle every(unsigned long delayMs, contextByteCallback callback, void* ctx) {
+      static_assert(Cfg::intervals > 0, "No intervals configured: define TOTAL_INTERVALS or add Intervals<N> to the Config");
+      byte idx = this->intervals.add(CallbackSlot<byte>(callback, ctx), delayMs, 0, 0);
+      return IntervalHandle(this, idx);
+    }
+
+    IntervalHandle repeat(unsigned long delayMs, unsigned int count, contextByteCallback callback, void* ctx) {
+      static_assert(Cfg::intervals > 0, "No intervals configured: define TOTAL_INTERVALS or add Intervals<N> to the Config");
+      byte idx = this->intervals.add(CallbackSlot<byte>(callback, ctx), delayMs, count, 0);
+      return IntervalHandle(this, idx);
+    }
+
+    void _setIntervalMessage(byte index, byte msg) {
+      this->intervals.setMessage(index, msg);
+    }
+
+    void _clearInterval(byte index) {
+      this->intervals.clear(index);
+    }
+
+    void _pauseInterval(byte index) {
+      this->intervals.pause(index);
+    }
+
+    void _resumeInterval(byte index) {
+      this->intervals.resume(index);
+    }
+
+    /****** UPDATE ***********************************************************/
+    // Kinds with no slots resolve to empty calls and compile away
+    void update() {
+      #ifdef DEVICE_REACTOR_PROFILE
+        drProfileKeepRunning();
+      #endif
+      DR_PROFILE_BEGIN(updateStart);
+      #ifdef DEVICE_REACTOR_LOOP_MONITOR
+        LoopMonitor* callerMonitor = drLoopMonitor();
+        drLoopMonitor() = &loopMonitor;
+        loopMonitor.beginPass();
+      #endif
+      DR_TRACE_ENTER(DR_SRC_UPDATE);
+
+      this->beginOutputs();
+      this->updateLEDs();
+
+      #if TOTAL_LED_GROUPS > 0
+        DR_SECTION_BEGIN(groupsStart, DR_SRC_LED_GROUPS);
+        for (byte i = 0; i < totalSetupLedGroups; i++) {
+          DR_SECTION_ITEM(i);
+          ledGroups[i].update();
         }
-        buttons[totalSetupButtons].init(pin, mode);
-        return totalSetupButtons++;
-      }
+        DR_SECTION_END(groupsStart, DR_SRC_LED_GROUPS);
+      #endif
 
-      Button& button(byte handle) {
-        if (handle >= totalSetupButtons || handle == INVALID_HANDLE) {
-          Serial.println("FATAL ERROR: Invalid button handle. Halting.");
-          while(1);  // Halt execution
+      this->updateButtons();
+      this->updateRotaryEncoders();
+      this->updateAnalogSensors();
+
+      #if TOTAL_BINDINGS > 0
+        // After the input passes so every binding sees this pass's values
+        updateBindings();
+      #endif
+
+      #if TOTAL_HYSTERESIS_CONTROLLERS > 0
+        // Every pass, so a switch held by a minimum time happens on time
+        // even when the sensor is sampled slowly
+        unsigned long controlNow = millis();
+        for (byte i = 0; i < totalSetupHysteresisControllers; i++) {
+          hysteresisControllers[i].update(controlNow);
         }
-        return buttons[handle];
-      }
-    #endif
+      #endif
 
-    /****** ANALOG SENSORS ***************************************************/
-    #if TOTAL_ANALOG_SENSORS > 0
-      AnalogSensor analogSensors[TOTAL_ANALOG_SENSORS];
+      #if TOTAL_RADIO_GROUPS > 0
+        for (byte i = 0; i < totalSetupRadioGroups; i++) {
+          radioGroups[i].update();
+        }
+      #endif
 
-      byte newAnalogSensor(byte pin) {
-        if (totalSetupAnalogSensors >= TOTAL_ANALOG_SENSORS) {
-          Serial.println("FATAL ERROR: Too many analog sensors. Increase TOTAL_ANALOG_SENSORS. Halting.");
-          while(1);
+      this->updateIntervals();
+
+      #if TOTAL_SEQUENCERS > 0
+        DR_SECTION_BEGIN(sequencersStart, DR_SRC_SEQUENCERS);
+        unsigned long stepNow = millis();
+        for (byte i = 0; i < totalSetupSequencers; i++) {
+          DR_SECTION_ITEM(i);
+          sequencers[i].update(stepNow);
         }
-        analogSensors[totalSetupAnalogSensors].init(pin);
-        return totalSetupAnalogSensors++;
-      }
+        DR_SECTION_END(sequencersStart, DR_SRC_SEQUENCERS);
+      #endif
 
-      AnalogSensor& analogSensor(byte handle) {
-        if (handle >= totalSetupAnalogSensors || handle == INVALID_HANDLE) {
-          Serial.println("FATAL ERROR: Invalid analog sensor handle. Halting.");
-          while(1);  // Halt execution
+      // Outputs are flushed last so every write made during this pass,
+      // including those from callbacks, goes out in a single frame
+      #if TOTAL_PIXEL_STRIPS > 0
+        DR_SECTION_BEGIN(pixelsStart, DR_SRC_PIXELS);
+        for (byte i = 0; i < totalSetupPixelStrips; i++) {
+          DR_SECTION_ITEM(i);
+          pixelStrips[i].update();
         }
-        return analogSensors[handle];
-      }
-    #endif
+        DR_SECTION_END(pixelsStart, DR_SRC_PIXELS);
+      #endif
 
-    /****** ROTARY ENCODERS **************************************************/
-    #if TOTAL_ROTARY_ENCODERS > 0
-      RotaryEncoder rotaryEncoders[TOTAL_ROTARY_ENCODERS];
+      #if TOTAL_SHIFT_REGISTERS > 0
+        DR_SECTION_BEGIN(shiftStart, DR_SRC_SHIFT);
+        shiftRegisters.update();
+        DR_SECTION_END(shiftStart, DR_SRC_SHIFT);
+      #endif
 
-      byte newRotaryEncoder(byte swPin, byte dtPin, byte clkPin) {
-        if (totalSetupRotaryEncoders >= TOTAL_ROTARY_ENCODERS) {
-          Serial.println("FATAL ERROR: Too many rotary encoders. Increase TOTAL_ROTARY_ENCODERS. Halting.");
-          while(1);
+      #if TOTAL_CHARLIE_ARRAYS > 0
+        DR_SECTION_BEGIN(charlieStart, DR_SRC_CHARLIE);
+        for (byte i = 0; i < totalSetupCharlieArrays; i++) {
+          DR_SECTION_ITEM(i);
+          charlieArrays[i].update();
         }
-        rotaryEncoders[totalSetupRotaryEncoders].init(swPin, dtPin, clkPin);
-        return totalSetupRotaryEncoders++;
+        DR_SECTION_END(charlieStart, DR_SRC_CHARLIE);
+      #endif
+
+      this->flushOutputs();
+
+      #ifdef DR_DEBUG_BUFFERED
+        drDebug().running = true;
+        drDebug().drain(DEVICE_REACTOR_DEBUG, DR_DEBUG_DRAIN);
+      #endif
+
+      DR_TRACE_LEAVE(DR_SRC_UPDATE);
+      DR_PROFILE_END(updateStart, DR_SRC_UPDATE);
+      #ifdef DEVICE_REACTOR_LOOP_MONITOR
+        loopMonitor.endPass();
+        drLoopMonitor() = callerMonitor;
+      #endif
+    }
+
+    /****** PROFILING ********************************************************/
+    #ifdef DEVICE_REACTOR_PROFILE
+      DeviceT() {
+        profileReset();
       }
 
-      RotaryEncoder& rotaryEncoder(byte handle) {
-        if (handle >= totalSetupRotaryEncoders || handle == INVALID_HANDLE) {
-          Serial.println("FATAL ERROR: Invalid rotary encoder handle. Halting.");
+      const ProfileStat& profileStat(byte source) {
+        if (source >= DR_SRC_COUNT) {
+          Serial.println("FATAL ERROR: Invalid profile source. Halting.");
           while(1);  // Halt execution
         }
-        return rotaryEncoders[handle];
+        return drProfileStats()[source];
+      }
+
+      void profileReset() {
+        memset(drProfileStats(), 0, sizeof(ProfileStat) * DR_SRC_COUNT);
+        drProfileStart();
+      }
+
+      // One line per source that has run: count, min/avg/max, then the
+      // non-empty histogram buckets as <upperBound:count
+      void profileReport(Stream& out) {
+        out.print(F("DeviceReactor profile ("));
+        out.print(F(DR_PROFILE_UNIT));
+        out.println(F(")"));
+        for (byte src = 0; src < DR_SRC_COUNT; src++) {
+          const ProfileStat& stat = drProfileStats()[src];
+          if (stat.count == 0) {
+            continue;
+          }
+          if (src >= DR_SRC_BUTTON_CB && src != DR_SRC_SEQUENCERS) {
+            out.print(F("  "));  // Callbacks are indented under their components
+          }
+          drPrintSource(out, src);
+          out.print(F(" n="));
+          out.print((unsigned long)stat.count);
+          out.print(F(" min="));
+          out.print((unsigned long)stat.minTicks);
+          out.print(F(" avg="));
+          out.print((unsigned long)(stat.totalTicks / stat.count));
+          out.print(F(" max="));
+          out.print((unsigned long)stat.maxTicks);
+          for (byte b = 0; b < DR_PROFILE_BUCKETS; b++) {
+            if (stat.histogram[b] == 0) {
+              continue;
+            }
+            if (b == DR_PROFILE_BUCKETS - 1) {
+              out.print(F(" >="));
+              out.print((unsigned long)(1UL << (b - 1)) << DR_PROFILE_SHIFT);
+            } else {
+              out.print(F(" <"));
+              out.print((unsigned long)(1UL << b) << DR_PROFILE_SHIFT);
+            }
+            out.print(':');
+            out.print((unsigned int)stat.histogram[b]);
+          }
+          out.println();
+        }
       }
     #endif
 
-    /****** INTERVALS ********************************************************/
-    #if TOTAL_INTERVALS > 0
-      Interval intervals;
 
-      IntervalHandle after(unsigned long delayMs, byteParamCallback callback) {
-        byte idx = intervals.add(callback, delayMs, 1, 0);  // Run once
-        return IntervalHandle(this, idx);
+    /****** LOOP MONITOR *****************************************************/
+    #ifdef DEVICE_REACTOR_LOOP_MONITOR
+      // Fires once per pass when update() runs past limitUs, or when the gap
+      // between two update() calls of this device exceeds it. source is a
+      // DR_SRC_* id and index the component handle (INVALID_HANDLE if not
+      // applicable).
+      void onOverrun(unsigned long limitUs, overrunCallback callback) {
+        loopMonitor.limitUs = limitUs;
+        loopMonitor.overrun = callback;
       }
 
-      IntervalHandle every(unsigned long delayMs, byteParamCallback callback) {
-        byte idx = intervals.add(callback, delayMs, 0, 0);  // Run forever
-        return IntervalHandle(this, idx);
+      const LoopMonitor& loopStats() {
+        return loopMonitor;
       }
 
-      IntervalHandle repeat(unsigned long delayMs, unsigned int count, byteParamCallback callback) {
-        byte idx = intervals.add(callback, delayMs, count, 0);  // Run count times
-        return IntervalHandle(this, idx);
+      void loopReset() {
+        LoopMonitor& monitor = loopMonitor;
+        monitor.passes = 0;
+        monitor.overruns = 0;
+        monitor.maxPeriod = 0;
+        monitor.maxDuration = 0;
+        memset(monitor.periodHistogram, 0, sizeof(monitor.periodHistogram));
+        memset(monitor.durationHistogram, 0, sizeof(monitor.durationHistogram));
       }
 
-      void _setIntervalMessage(byte index, byte msg) {
-        intervals.setMessage(index, msg);
+      void loopReport(Stream& out) {
+        const LoopMonitor& monitor = loopMonitor;
+        out.print(F("DeviceReactor loop (us) passes="));
+        out.print(monitor.passes);
+        out.print(F(" overruns="));
+        out.print(monitor.overruns);
+        out.print(F(" maxPeriod="));
+        out.print(monitor.maxPeriod);
+        out.print(F(" maxDuration="));
+        out.println(monitor.maxDuration);
+        printLoopHistogram(out, F("period  "), monitor.periodHistogram);
+        printLoopHistogram(out, F("duration"), monitor.durationHistogram);
       }
+    #endif
 
-      void _clearInterval(byte index) {
-        intervals.clear(index);
+    /****** EVENT TRACE ******************************************************/
+    #ifdef DEVICE_REACTOR_TRACE
+      // Record a user event (use ids from DR_EV_USER up) in the trace
+      void trace(byte event, int value = 0) {
+        DR_TRACE_EVENT(event, value);
       }
 
-      void _pauseInterval(byte index) {
-        intervals.pause(index);
+      // Writes the trace as binary and empties it:
+      //   "DRT1", record size (1 byte), count (2), overwritten (4),
+      //   micros() of the oldest record (4), then count 8-byte records
+      //   oldest first. All fields are little-endian.
+      void traceDump(Stream& out) {
+        TraceBuffer& buffer = drTrace();
+        out.write((const uint8_t*)"DRT1", 4);
+        out.write((uint8_t)sizeof(TraceRecord));
+        out.write((const uint8_t*)&buffer.count, 2);
+        out.write((const uint8_t*)&buffer.overwritten, 4);
+        out.write((const uint8_t*)&buffer.oldestTime, 4);
+        uint16_t slot = (buffer.head - buffer.count) & (DR_TRACE_RECORDS - 1);
+        for (uint16_t i = 0; i < buffer.count; i++) {
+          out.write((const uint8_t*)&buffer.records[slot], sizeof(TraceRecord));
+          slot = (slot + 1) & (DR_TRACE_RECORDS - 1);
+        }
+        traceClear();
       }
 
-      void _resumeInterval(byte index) {
-        intervals.resume(index);
+      void traceClear() {
+        drTrace().count = 0;
+        drTrace().overwritten = 0;
       }
     #endif
 
-    /****** UPDATE ***********************************************************/
-    void update() {
-      #if TOTAL_LEDS > 0
-        for (byte i = 0; i < totalSetupLEDs; i++) {
-          LEDs[i].update();
-        }
-      #endif
+    /****** INPUT RECORDING **************************************************/
+    #ifdef DEVICE_REACTOR_RECORD
+      // Streams every sampled input change to out until stopRecording().
+      // Use a port the sketch doesn't print to (Serial1, an SD file, ...).
+      void recordInputs(Stream& out) {
+        drRecorder().start(out);
+      }
+
+      void stopRecording() {
+        drRecorder().out = nullptr;
+      }
+    #endif
+
+    /****** DEBUG OUTPUT *****************************************************/
+    #ifdef DR_DEBUG_BUFFERED
+      // Blocks until every queued debug message has been handed to the port
+      void debugFlush() {
+        drDebug().flush(DEVICE_REACTOR_DEBUG);
+      }
+
+      // Messages lost because the debug buffer was full
+      unsigned long debugDropped() {
+        return drDebug().droppedTotal;
+      }
+    #endif
 
-      #if TOTAL_BUTTONS > 0
-        for (byte i = 0; i < totalSetupButtons; i++) {
-          buttons[i].update();
+  private:
+    #ifdef DEVICE_REACTOR_LOOP_MONITOR
+      LoopMonitor loopMonitor;
+    #endif
+
+    #if TOTAL_SUBSCRIBERS > 0
+      EventBus eventBus;
+    #endif
+
+    #if TOTAL_BINDINGS > 0
+      Binding bindings[TOTAL_BINDINGS];
+      byte totalSetupBindings = 0;
+
+      Binding& newBinding(byte source) {
+        if (totalSetupBindings >= TOTAL_BINDINGS) {
+          Serial.println("FATAL ERROR: Too many bindings. Increase TOTAL_BINDINGS. Halting.");
+          while(1);
         }
-      #endif
+        Binding& slot = bindings[totalSetupBindings++];
+        slot.source = source;
+        return slot;
+      }
+
+      // Handles were checked at bind time, so components are indexed directly
+      void updateBindings() {
+        for (byte i = 0; i < totalSetupBindings; i++) {
+          Binding& b = bindings[i];
+          switch (b.kind) {
+            case BIND_LEVEL: {
+              AnalogSensor& sensor = this->analogSensorArray()[b.source];
+              if (!sensor.hasInitialRead || sensor.currentReportedValue == b.last) {
+                break;
+              }
+              b.last = sensor.currentReportedValue;
+              unsigned long level = ((unsigned long)(b.last - b.low) * b.scale) >> 16;
+              LED& led = this->ledArray()[b.target];
+              led.setLevel(level > 255 ? 255 : level);
+              if (led.state != HIGH) {
+                led.turnOn();
+              }
+              break;
+            }
 
-      #if TOTAL_ROTARY_ENCODERS > 0
-        for (byte i = 0; i < totalSetupRotaryEncoders; i++) {
-          rotaryEncoders[i].update();
+            case BIND_TOGGLE:
+            case BIND_STATE: {
+              int held = this->buttonArray()[b.source].isPressed();
+              if (held == b.last) {
+                break;
+              }
+              b.last = held;
+              LED& led = this->ledArray()[b.target];
+              if (b.kind == BIND_STATE) {
+                if (held) {
+                  led.turnOn();
+                } else {
+                  led.turnOff();
+                }
+              } else if (held) {
+                led.flip();
+              }
+              break;
+            }
+          }
         }
-      #endif
+      }
+    #endif
 
-      #if TOTAL_ANALOG_SENSORS > 0
-        for (byte i = 0; i < totalSetupAnalogSensors; i++) {
-          analogSensors[i].update();
+    #ifdef DEVICE_REACTOR_LOOP_MONITOR
+      static void printLoopHistogram(Stream& out, const __FlashStringHelper* label, const uint16_t* histogram) {
+        out.print(label);
+        for (byte b = 0; b < DR_LOOP_BUCKETS; b++) {
+          out.print(b == DR_LOOP_BUCKETS - 1 ? F(" >=") : F(" <"));
+          out.print((unsigned long)(b == DR_LOOP_BUCKETS - 1 ? b : b + 1) * DR_LOOP_BUCKET_US);
+          out.print(':');
+          out.print((unsigned int)histogram[b]);
         }
-      #endif
+        out.println();
+      }
+    #endif
 
-      #if TOTAL_INTERVALS > 0
-        intervals.update();
-      #endif
-    }
+    #if TOTAL_LED_GROUPS > 0
+      byte totalSetupLedGroups = 0;
+    #endif
 
-  private:
+    #if TOTAL_HYSTERESIS_CONTROLLERS > 0
+      byte totalSetupHysteresisControllers = 0;
+    #endif
 
-    #if TOTAL_LEDS > 0
-      byte totalSetupLEDs = 0;
+    #if TOTAL_RADIO_GROUPS > 0
+      byte totalSetupRadioGroups = 0;
     #endif
 
-    #if TOTAL_BUTTONS > 0
-      byte totalSetupButtons = 0;
+    #if TOTAL_SEQUENCERS > 0
+      byte totalSetupSequencers = 0;
     #endif
 
-    #if TOTAL_ROTARY_ENCODERS > 0
-      byte totalSetupRotaryEncoders = 0;
+    #if TOTAL_PIXEL_STRIPS > 0
+      byte totalSetupPixelStrips = 0;
     #endif
 
-    #if TOTAL_ANALOG_SENSORS > 0
-      byte totalSetupAnalogSensors = 0;
+    #if TOTAL_CHARLIE_ARRAYS > 0
+      byte totalSetupCharlieArrays = 0;
     #endif
 };
 
+// The device a sketch gets from the TOTAL_* macros
+typedef Config<Leds<TOTAL_LEDS>, Buttons<TOTAL_BUTTONS>, AnalogSensors<TOTAL_ANALOG_SENSORS>,
+               RotaryEncoders<TOTAL_ROTARY_ENCODERS>, Intervals<TOTAL_INTERVALS>> DeviceConfig;
+typedef DeviceT<DeviceConfig> Device;
+typedef Device::IntervalHandle IntervalHandle;
+
 /*****************************************************************************
- * INTERVALHANDLE IMPLEMENTATION
+ * MEMORY FOOTPRINT
  *****************************************************************************/
-#if TOTAL_INTERVALS > 0
-  inline IntervalHandle& IntervalHandle::withMessage(byte msg) {
-    device->_setIntervalMessage(index, msg);
-    return *this;
+// Static RAM of each component class and of a device, plus the buffers the
+// diagnostics options add. All constexpr, so a sketch can guard its budget at
+// compile time:
+//   static_assert(DeviceFootprint::total() <= 1024, "Device too large");
+// DeviceFootprint describes Device; DeviceFootprintT<Cfg> describes DeviceT<Cfg>.
+template <class Cfg>
+struct DeviceFootprintT {
+  // Bytes per component
+  static constexpr unsigned int led() { return sizeof(LED); }
+  static constexpr unsigned int button() { return sizeof(Button); }
+  static constexpr unsigned int analogSensor() { return sizeof(AnalogSensor); }
+  static constexpr unsigned int analogZones() { return sizeof(AnalogSensor::Zone) * MAX_ZONES_PER_SENSOR; }  // Part of analogSensor()
+  static constexpr unsigned int rotaryEncoder() { return sizeof(RotaryEncoder); }
+  static constexpr unsigned int intervalSlot() { return sizeof(IntervalSlots<8>) / 8; }
+
+  // Bytes per component array inside the device
+  static constexpr unsigned int leds() { return Cfg::leds * sizeof(LED); }
+  static constexpr unsigned int buttons() { return Cfg::buttons * sizeof(Button); }
+  static constexpr unsigned int analogSensors() { return Cfg::analogSensors * sizeof(AnalogSensor); }
+  static constexpr unsigned int rotaryEncoders() { return Cfg::rotaryEncoders * sizeof(RotaryEncoder); }
+  static constexpr unsigned int intervals() {
+    return Cfg::intervals > 0 ? sizeof(IntervalPool<Cfg::intervals>) : 0;
+  }
+
+  static constexpr unsigned int device() { return sizeof(DeviceT<Cfg>); }
+
+  // Groups, strips, the loop monitor, bookkeeping and padding
+  static constexpr unsigned int other() {
+    return device() - leds() - buttons() - analogSensors() - rotaryEncoders() - intervals();
   }
 
-  inline void IntervalHandle::stop() {
-    device->_clearInterval(index);
+  // Buffers of the diagnostics options, 0 when the option is not defined.
+  // They exist once per sketch, however many devices it has.
+  static constexpr unsigned int profileTable() {
+    #ifdef DEVICE_REACTOR_PROFILE
+      return sizeof(ProfileStat) * DR_SRC_COUNT;
+    #else
+      return 0;
+    #endif
   }
 
-  inline void IntervalHandle::pause() {
-    device->_pauseInterval(index);
+  static constexpr unsigned int traceBuffer() {
+    #ifdef DEVICE_REACTOR_TRACE
+      return sizeof(TraceBuffer);
+    #else
+      return 0;
+    #endif
   }
 
-  inline void IntervalHandle::resume() {
-    device->_resumeInterval(index);
+  static constexpr unsigned int debugBuffer() {
+    #ifdef DR_DEBUG_BUFFERED
+      return sizeof(DebugBuffer);
+    #else
+      return 0;
+    #endif
   }
-#endif
 
-#endif // DEVICE_REACTOR_H
\ No newline at end of file
+  static constexpr unsigned int inputRecorder() {
+    #ifdef DEVICE_REACTOR_RECORD
+      return sizeof(InputRecorder);
+    #else
+      return 0;
+    #endif
+  }
+
+  // The idle monitor used outside update(); each device's own is in other()
+  static constexpr unsigned int loopMonitor() {
+    #ifdef DEVICE_REACTOR_LOOP_MONITOR
+      return sizeof(LoopMonitor);
+    #else
+      return 0;
+    #endif
+  }
+
+  static constexpr unsigned int diagnostics() {
+    return profileTable() + traceBuffer() + debugBuffer() + inputRecorder() + loopMonitor();
+  }
+
+  static constexpr unsigned int total() { return device() + diagnostics(); }
+
+  static void report(Print& out) {
+    out.println(F("Component       Each  Count  Total"));
+    printRow(out, F("LED"), led(), Cfg::leds, leds());
+    printRow(out, F("Button"), button(), Cfg::buttons, buttons());
+    printRow(out, F("AnalogSensor"), analogSensor(), Cfg::analogSensors, analogSensors());
+    printRow(out, F("  zones"), analogZones(), Cfg::analogSensors, analogZones() * Cfg::analogSensors);
+    printRow(out, F("RotaryEncoder"), rotaryEncoder(), Cfg::rotaryEncoders, rotaryEncoders());
+    printRow(out, F("Interval"), intervalSlot(), Cfg::intervals, intervals());
+    printTotal(out, F("Other"), other());
+    printTotal(out, F("Device"), device());
+    printTotal(out, F("Diagnostics"), diagnostics());
+    printTotal(out, F("Total"), total());
+  }
+
+  private:
+    static void printColumn(Print& out, unsigned long value, byte width) {
+      byte digits = 1;
+      for (unsigned long v = value; v >= 10; v /= 10) {
+        digits++;
+      }
+      for (; digits < width; digits++) {
+        out.print(' ');
+      }
+      out.print(value);
+    }
+
+    static void printName(Print& out, const __FlashStringHelper* name) {
+      for (byte length = out.print(name); length < 14; length++) {
+        out.print(' ');
+      }
+    }
+
+    static void printRow(Print& out, const __FlashStringHelper* name, unsigned int each, unsigned int count, unsigned int total) {
+      printName(out, name);
+      printColumn(out, each, 6);
+      printColumn(out, count, 7);
+      printColumn(out, total, 7);
+      out.println();
+    }
+
+    // Each and Count are left blank
+    static void printTotal(Print& out, const __FlashStringHelper* name, unsigned int total) {
+      printName(out, name);
+      out.print(F("             "));
+      printColumn(out, total, 7);
+      out.println();
+    }
+};
+
+typedef DeviceFootprintT<DeviceConfig> DeviceFootprint;
+
+#endif // DEVICE_REACTOR_H